@@ -1,8 +1,10 @@
 #pragma once
 
 #include <eosio/binary_extension.hpp>
+#include <eosio/crypto.hpp>
 #include <eosio/eosio.hpp>
 #include <eosio/ignore.hpp>
+#include <eosio/singleton.hpp>
 #include <eosio/transaction.hpp>
 
 namespace eosio {
@@ -86,7 +88,8 @@ namespace eosio {
           * - `proposal_name` is found in the proposals table,
           * - all requested approvals are received,
           * - proposed transaction is not expired,
-          * - and approval accounts are not found in invalidations table.
+          * - and approval accounts are not found in invalidations table. The table is not probed when
+          *   no account invalidated since the proposal was created.
           *
           * If all preconditions are met the transaction is executed as a deferred transaction,
           * and the proposal is erased from the proposals table.
@@ -100,11 +103,44 @@ namespace eosio {
          /**
           * Invalidate action allows an `account` to invalidate itself, that is, its name is added to
           * the invalidations table and this table will be cross referenced when exec is performed.
+          * It also bumps the global invalidation epoch.
           *
           * @param account - The account invalidating the transaction
           */
          [[eosio::action]]
          void invalidate( name account );
+         /**
+          * Stagechunk action appends `chunk` to the staged transaction `upload_name` of `proposer`,
+          * so that a transaction too large for one `propose` action can be uploaded in parts.
+          * Each chunk is stored as a row of its own and the chunks are only joined by `propstaged`.
+          * Storage changes are billed to `proposer`.
+          *
+          * @param proposer - The account uploading the transaction
+          * @param upload_name - The name of the staged transaction
+          * @param chunk - The next bytes of the packed transaction
+          */
+         [[eosio::action]]
+         void stagechunk( name proposer, name upload_name, const std::vector<char>& chunk );
+         /**
+          * Propstaged action creates a proposal from the chunks of the staged transaction `upload_name`
+          * joined in upload order, with the same checks as `propose`, and erases the staged transaction.
+          *
+          * @param proposer - The account proposing a transaction
+          * @param proposal_name - The name of the proposal (should be unique for proposer)
+          * @param requested - Permission levels expected to approve the proposal
+          * @param upload_name - The name of the staged transaction
+          */
+         [[eosio::action]]
+         void propstaged( name proposer, name proposal_name, const std::vector<permission_level>& requested,
+                          name upload_name );
+         /**
+          * Dropstaged action erases the staged transaction `upload_name` of `proposer`.
+          *
+          * @param proposer - The account which uploaded the transaction
+          * @param upload_name - The name of the staged transaction
+          */
+         [[eosio::action]]
+         void dropstaged( name proposer, name upload_name );
 
          using propose_action = eosio::action_wrapper<"propose"_n, &multisig::propose>;
          using approve_action = eosio::action_wrapper<"approve"_n, &multisig::approve>;
@@ -112,17 +148,54 @@ namespace eosio {
          using cancel_action = eosio::action_wrapper<"cancel"_n, &multisig::cancel>;
          using exec_action = eosio::action_wrapper<"exec"_n, &multisig::exec>;
          using invalidate_action = eosio::action_wrapper<"invalidate"_n, &multisig::invalidate>;
+         using stagechunk_action = eosio::action_wrapper<"stagechunk"_n, &multisig::stagechunk>;
+         using propstaged_action = eosio::action_wrapper<"propstaged"_n, &multisig::propstaged>;
+         using dropstaged_action = eosio::action_wrapper<"dropstaged"_n, &multisig::dropstaged>;
 
       private:
          struct [[eosio::table]] proposal {
             name                            proposal_name;
-            std::vector<char>               packed_transaction;
+            std::vector<char>               packed_transaction;   // empty if the transaction is in the blob table
+            binary_extension<checksum256>   trx_hash;             // sha256 of the transaction in the blob table
 
             uint64_t primary_key()const { return proposal_name.value; }
          };
 
          typedef eosio::multi_index< "proposal"_n, proposal > proposals;
 
+         /**
+          * A packed proposed transaction, shared by all proposals of the same transaction by one proposer.
+          * Scoped by proposer and billed to it, the row is erased when its last proposal is gone.
+          */
+         struct [[eosio::table]] trx_blob {
+            uint64_t            id;
+            checksum256         trx_hash;
+            uint32_t            refcount = 0;
+            std::vector<char>   packed_transaction;
+
+            uint64_t primary_key()const { return id; }
+            checksum256 by_hash()const { return trx_hash; }
+         };
+
+         typedef eosio::multi_index< "trxblobs"_n, trx_blob,
+                                     indexed_by<"byhash"_n, const_mem_fun<trx_blob, checksum256, &trx_blob::by_hash>>
+                                   > trx_blobs;
+
+         // one uploaded chunk of a staged transaction, scoped by proposer
+         struct [[eosio::table]] staged_chunk {
+            uint64_t            id;
+            name                upload_name;
+            uint32_t            seq;      // upload order of the chunk within `upload_name`
+            std::vector<char>   chunk;
+
+            uint64_t primary_key()const { return id; }
+            uint128_t by_upload()const { return (uint128_t(upload_name.value) << 64) | seq; }
+         };
+
+         typedef eosio::multi_index< "stagedchunk"_n, staged_chunk,
+                                     indexed_by<"byupload"_n, const_mem_fun<staged_chunk, uint128_t, &staged_chunk::by_upload>>
+                                   > staged_chunks;
+
          struct approval {
             permission_level level;
             time_point       time;
@@ -136,6 +209,7 @@ namespace eosio {
             //doesn't change serialized data size. So, we use the same type.
             std::vector<approval>   requested_approvals;
             std::vector<approval>   provided_approvals;
+            binary_extension<uint64_t> inval_epoch;   // invalidation epoch when the proposal was created
 
             uint64_t primary_key()const { return proposal_name.value; }
          };
@@ -149,5 +223,17 @@ namespace eosio {
          };
 
          typedef eosio::multi_index< "invals"_n, invalidation > invalidations;
+
+         struct [[eosio::table]] inval_state {
+            uint64_t     epoch = 0;   // number of invalidate actions so far
+         };
+
+         typedef eosio::singleton< "invalstate"_n, inval_state > inval_state_singleton;
+
+         void store_proposal( name proposer, name proposal_name, const std::vector<permission_level>& requested,
+                              const char* trx_pos, size_t size );
+         const std::vector<char>& get_packed_transaction( const proposal& prop, trx_blobs& blobs );
+         void release_transaction( const proposal& prop, trx_blobs& blobs );
+         uint32_t erase_staged( staged_chunks& chunks, name upload_name );
    };
 } /// namespace eosio
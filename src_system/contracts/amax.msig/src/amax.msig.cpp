@@ -4,6 +4,8 @@
 
 #include <amax.msig/amax.msig.hpp>
 
+#include <limits>
+
 namespace eosio {
 
 void multisig::propose( ignore<name> proposer,
@@ -14,22 +16,29 @@ void multisig::propose( ignore<name> proposer,
    name _proposer;
    name _proposal_name;
    std::vector<permission_level> _requested;
-   transaction_header _trx_header;
 
    _ds >> _proposer >> _proposal_name >> _requested;
 
    const char* trx_pos = _ds.pos();
    size_t size    = _ds.remaining();
-   _ds >> _trx_header;
+   store_proposal( _proposer, _proposal_name, _requested, trx_pos, size );
+}
+
+void multisig::store_proposal( name proposer, name proposal_name, const std::vector<permission_level>& requested,
+                               const char* trx_pos, size_t size )
+{
+   transaction_header trx_header;
+   datastream<const char*> ds( trx_pos, size );
+   ds >> trx_header;
 
-   require_auth( _proposer );
-   check( _trx_header.expiration >= eosio::time_point_sec(current_time_point()), "transaction expired" );
+   require_auth( proposer );
+   check( trx_header.expiration >= eosio::time_point_sec(current_time_point()), "transaction expired" );
    //check( trx_header.actions.size() > 0, "transaction must have at least one action" );
 
-   proposals proptable( get_self(), _proposer.value );
-   check( proptable.find( _proposal_name.value ) == proptable.end(), "proposal with the same name exists" );
+   proposals proptable( get_self(), proposer.value );
+   check( proptable.find( proposal_name.value ) == proptable.end(), "proposal with the same name exists" );
 
-   auto packed_requested = pack(_requested);
+   auto packed_requested = pack(requested);
    auto res =  check_transaction_authorization(
                   trx_pos, size,
                   (const char*)0, 0,
@@ -38,24 +47,69 @@ void multisig::propose( ignore<name> proposer,
 
    check( res > 0, "transaction authorization failed" );
 
-   std::vector<char> pkd_trans;
-   pkd_trans.resize(size);
-   memcpy((char*)pkd_trans.data(), trx_pos, size);
-   proptable.emplace( _proposer, [&]( auto& prop ) {
-      prop.proposal_name       = _proposal_name;
-      prop.packed_transaction  = pkd_trans;
+   // identical transactions of one proposer share one blob row
+   auto trx_hash = sha256( trx_pos, size );
+   trx_blobs blobs( get_self(), proposer.value );
+   auto hash_idx = blobs.get_index<"byhash"_n>();
+   auto blob_it = hash_idx.find( trx_hash );
+   if ( blob_it == hash_idx.end() ) {
+      blobs.emplace( proposer, [&]( auto& b ) {
+         b.id                 = blobs.available_primary_key();
+         b.trx_hash           = trx_hash;
+         b.refcount           = 1;
+         b.packed_transaction.assign( trx_pos, trx_pos + size );
+      });
+   } else {
+      hash_idx.modify( blob_it, same_payer, [&]( auto& b ) {
+         ++b.refcount;
+      });
+   }
+
+   proptable.emplace( proposer, [&]( auto& prop ) {
+      prop.proposal_name       = proposal_name;
+      prop.trx_hash            = trx_hash;
    });
 
-   approvals apptable( get_self(), _proposer.value );
-   apptable.emplace( _proposer, [&]( auto& a ) {
-      a.proposal_name       = _proposal_name;
-      a.requested_approvals.reserve( _requested.size() );
-      for ( auto& level : _requested ) {
+   inval_state_singleton inval_state( get_self(), get_self().value );
+   approvals apptable( get_self(), proposer.value );
+   apptable.emplace( proposer, [&]( auto& a ) {
+      a.proposal_name       = proposal_name;
+      a.requested_approvals.reserve( requested.size() );
+      for ( auto& level : requested ) {
          a.requested_approvals.push_back( approval{ level, time_point{ microseconds{0} } } );
       }
+      a.inval_epoch         = inval_state.get_or_default().epoch;
    });
 }
 
+const std::vector<char>& multisig::get_packed_transaction( const proposal& prop, trx_blobs& blobs ) {
+   if ( !prop.trx_hash ) {
+      return prop.packed_transaction;
+   }
+   auto hash_idx = blobs.get_index<"byhash"_n>();
+   auto blob_it = hash_idx.find( *prop.trx_hash );
+   check( blob_it != hash_idx.end(), "proposed transaction not found" );
+   return blob_it->packed_transaction;
+}
+
+void multisig::release_transaction( const proposal& prop, trx_blobs& blobs ) {
+   if ( !prop.trx_hash ) {
+      return;
+   }
+   auto hash_idx = blobs.get_index<"byhash"_n>();
+   auto blob_it = hash_idx.find( *prop.trx_hash );
+   if ( blob_it == hash_idx.end() ) {
+      return;
+   }
+   if ( blob_it->refcount > 1 ) {
+      hash_idx.modify( blob_it, same_payer, [&]( auto& b ) {
+         --b.refcount;
+      });
+   } else {
+      hash_idx.erase( blob_it );
+   }
+}
+
 void multisig::approve( name proposer, name proposal_name, permission_level level,
                         const eosio::binary_extension<eosio::checksum256>& proposal_hash )
 {
@@ -64,7 +118,9 @@ void multisig::approve( name proposer, name proposal_name, permission_level leve
    if( proposal_hash ) {
       proposals proptable( get_self(), proposer.value );
       auto& prop = proptable.get( proposal_name.value, "proposal not found" );
-      assert_sha256( prop.packed_transaction.data(), prop.packed_transaction.size(), *proposal_hash );
+      trx_blobs blobs( get_self(), proposer.value );
+      const auto& packed_trx = get_packed_transaction( prop, blobs );
+      assert_sha256( packed_trx.data(), packed_trx.size(), *proposal_hash );
    }
 
    approvals apptable( get_self(), proposer.value );
@@ -103,9 +159,11 @@ void multisig::cancel( name proposer, name proposal_name, name canceler ) {
    proposals proptable( get_self(), proposer.value );
    auto& prop = proptable.get( proposal_name.value, "proposal not found" );
 
+   trx_blobs blobs( get_self(), proposer.value );
    if( canceler != proposer ) {
-      check( unpack<transaction_header>( prop.packed_transaction ).expiration < eosio::time_point_sec(current_time_point()), "cannot cancel until expiration" );
+      check( unpack<transaction_header>( get_packed_transaction( prop, blobs ) ).expiration < eosio::time_point_sec(current_time_point()), "cannot cancel until expiration" );
    }
+   release_transaction( prop, blobs );
    proptable.erase(prop);
 
    //remove from new table
@@ -120,8 +178,10 @@ void multisig::exec( name proposer, name proposal_name, name executer ) {
 
    proposals proptable( get_self(), proposer.value );
    auto& prop = proptable.get( proposal_name.value, "proposal not found" );
+   trx_blobs blobs( get_self(), proposer.value );
+   const auto& packed_trx = get_packed_transaction( prop, blobs );
    transaction_header trx_header;
-   datastream<const char*> ds( prop.packed_transaction.data(), prop.packed_transaction.size() );
+   datastream<const char*> ds( packed_trx.data(), packed_trx.size() );
    ds >> trx_header;
    check( trx_header.expiration >= eosio::time_point_sec(current_time_point()), "transaction expired" );
 
@@ -131,17 +191,23 @@ void multisig::exec( name proposer, name proposal_name, name executer ) {
    invalidations inv_table( get_self(), get_self().value );
    check( apps_it != apptable.end(), "proposal not found" );
    approvals.reserve( apps_it->provided_approvals.size() );
+   // an unchanged epoch means nobody invalidated since the proposal was created, so all approvals stand
+   inval_state_singleton inval_state( get_self(), get_self().value );
+   bool invalidated = !apps_it->inval_epoch || *apps_it->inval_epoch != inval_state.get_or_default().epoch;
    for ( auto& p : apps_it->provided_approvals ) {
-      auto it = inv_table.find( p.level.actor.value );
-      if ( it == inv_table.end() || it->last_invalidation_time < p.time ) {
-         approvals.push_back(p.level);
+      if ( invalidated ) {
+         auto it = inv_table.find( p.level.actor.value );
+         if ( it != inv_table.end() && it->last_invalidation_time >= p.time ) {
+            continue;
+         }
       }
+      approvals.push_back(p.level);
    }
    apptable.erase(apps_it);
 
    auto packed_provided_approvals = pack(approvals);
    auto res =  check_transaction_authorization(
-                  prop.packed_transaction.data(), prop.packed_transaction.size(),
+                  packed_trx.data(), packed_trx.size(),
                   (const char*)0, 0,
                   packed_provided_approvals.data(), packed_provided_approvals.size()
                );
@@ -149,8 +215,9 @@ void multisig::exec( name proposer, name proposal_name, name executer ) {
    check( res > 0, "transaction authorization failed" );
 
    send_deferred( (uint128_t(proposer.value) << 64) | proposal_name.value, executer,
-                  prop.packed_transaction.data(), prop.packed_transaction.size() );
+                  packed_trx.data(), packed_trx.size() );
 
+   release_transaction( prop, blobs );
    proptable.erase(prop);
 }
 
@@ -168,6 +235,64 @@ void multisig::invalidate( name account ) {
             i.last_invalidation_time = current_time_point();
          });
    }
+
+   inval_state_singleton inval_state( get_self(), get_self().value );
+   auto state = inval_state.get_or_default();
+   ++state.epoch;
+   inval_state.set( state, get_self() );
+}
+
+void multisig::stagechunk( name proposer, name upload_name, const std::vector<char>& chunk ) {
+   require_auth( proposer );
+   check( !chunk.empty(), "empty chunk" );
+
+   // appends a row instead of rewriting the chunks uploaded so far
+   staged_chunks chunks( get_self(), proposer.value );
+   auto upload_idx = chunks.get_index<"byupload"_n>();
+   auto last = upload_idx.upper_bound( (uint128_t(upload_name.value) << 64) | std::numeric_limits<uint32_t>::max() );
+   uint32_t seq = 0;
+   if ( last != upload_idx.begin() && (--last)->upload_name == upload_name ) {
+      seq = last->seq + 1;
+   }
+   chunks.emplace( proposer, [&]( auto& c ) {
+         c.id          = chunks.available_primary_key();
+         c.upload_name = upload_name;
+         c.seq         = seq;
+         c.chunk       = chunk;
+      });
+}
+
+void multisig::propstaged( name proposer, name proposal_name, const std::vector<permission_level>& requested,
+                           name upload_name )
+{
+   staged_chunks chunks( get_self(), proposer.value );
+   auto upload_idx = chunks.get_index<"byupload"_n>();
+   auto first = upload_idx.lower_bound( uint128_t(upload_name.value) << 64 );
+   check( first != upload_idx.end() && first->upload_name == upload_name, "staged transaction not found" );
+
+   std::vector<char> packed_trx;
+   for ( auto it = first; it != upload_idx.end() && it->upload_name == upload_name; ++it ) {
+      packed_trx.insert( packed_trx.end(), it->chunk.begin(), it->chunk.end() );
+   }
+   store_proposal( proposer, proposal_name, requested, packed_trx.data(), packed_trx.size() );
+   erase_staged( chunks, upload_name );
+}
+
+void multisig::dropstaged( name proposer, name upload_name ) {
+   require_auth( proposer );
+   staged_chunks chunks( get_self(), proposer.value );
+   check( erase_staged( chunks, upload_name ) > 0, "staged transaction not found" );
+}
+
+uint32_t multisig::erase_staged( staged_chunks& chunks, name upload_name ) {
+   auto upload_idx = chunks.get_index<"byupload"_n>();
+   auto it = upload_idx.lower_bound( uint128_t(upload_name.value) << 64 );
+   uint32_t erased = 0;
+   while ( it != upload_idx.end() && it->upload_name == upload_name ) {
+      it = upload_idx.erase( it );
+      ++erased;
+   }
+   return erased;
 }
 
 } /// namespace eosio
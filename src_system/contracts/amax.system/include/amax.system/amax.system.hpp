@@ -11,7 +11,7 @@
 #include <amax.system/exchange_state.hpp>
 #include <amax.system/native.hpp>
 
-#include <deque>
+#include <map>
 #include <optional>
 #include <string>
 #include <type_traits>
@@ -27,6 +27,7 @@
 namespace eosiosystem {
 
    using eosio::asset;
+   using eosio::binary_extension;
    using eosio::block_timestamp;
    using eosio::check;
    using eosio::const_mem_fun;
@@ -74,6 +75,10 @@ namespace eosiosystem {
    static constexpr int64_t  ram_gift_bytes        = 1400;
 
    static constexpr uint32_t refund_delay_sec      = 3 * seconds_per_day;
+   static constexpr size_t   max_queued_refunds    = 100; // owners per `queuerefunds`
+
+   // `producers` rows migrated to `prodvotes` by each producer schedule update until the migration is done
+   static constexpr uint16_t max_prodvotes_migration_per_schedule = 50;
 
 
   /**
@@ -120,6 +125,28 @@ namespace eosiosystem {
 
    typedef eosio::multi_index< "bidrefunds"_n, bid_refund > bid_refund_table;
 
+   // The outbid balance of a bidder across all name auctions, withdrawn with `bidwithdraw`:
+   // - the `bidder` account name owning the balance
+   // - the `balance` of bids that have been outbid and not withdrawn yet
+   struct [[eosio::table, eosio::contract("amax.system")]] bid_balance {
+      name         bidder;
+      asset        balance;
+
+      uint64_t primary_key()const { return bidder.value; }
+   };
+
+   typedef eosio::multi_index< "bidbalances"_n, bid_balance > bid_balance_table;
+
+   // Name auction settings, set with `cfgnamebid`:
+   // - `max_closes_per_day` the maximum number of matured auctions `onblock` closes once a day
+   struct [[eosio::table("namebidcfg"), eosio::contract("amax.system")]] name_bid_config {
+      uint16_t     max_closes_per_day = 1;
+
+      EOSLIB_SERIALIZE( name_bid_config, (max_closes_per_day) )
+   };
+
+   typedef eosio::singleton< "namebidcfg"_n, name_bid_config > name_bid_config_singleton;
+
    // Defines new global state parameters.
    struct [[eosio::table("global"), eosio::contract("amax.system")]] amax_global_state : eosio::blockchain_parameters {
       uint64_t free_ram()const { return max_ram_size - total_ram_bytes_reserved; }
@@ -160,9 +187,11 @@ namespace eosiosystem {
    }
 
    // Defines `producer_info` structure to be stored in `producer_info` table, added after version 1.0
+   // Holds the cold producer metadata, which is only written by `regproducer`, `unregprod` and `rmvproducer`.
+   // The vote tally lives in the `prodvotes` table, see `producer_votes`.
    struct [[eosio::table, eosio::contract("amax.system")]] producer_info {
       name                                                     owner;
-      double                                                   total_votes = 0;
+      double                                                   total_votes = 0; /// legacy, superseded by `producer_votes::total_votes`
       eosio::public_key                                        producer_key; /// a packed public key object
       bool                                                     is_active = true;
       std::string                                              url;
@@ -187,7 +216,26 @@ namespace eosiosystem {
                                        (last_claimed_time)(unclaimed_rewards)(producer_authority) )
    };
 
-   // Voter info. Voter info stores information about the voter:
+   // Defines `producer_votes` structure to be stored in `prodvotes` table. It is the hot part of a producer
+   // row, modified on every vote change, and kept small so that vote updates don't reserialize the metadata:
+   // - `owner` the producer
+   // - `total_votes` the total vote weight of the producer
+   // - `is_active` whether the producer is currently registered
+   struct [[eosio::table, eosio::contract("amax.system")]] producer_votes {
+      name     owner;
+      double   total_votes = 0;
+      bool     is_active   = true;
+
+      uint64_t primary_key()const { return owner.value;                             }
+      double   by_votes()const    { return is_active ? -total_votes : total_votes;  }
+      bool     active()const      { return is_active;                               }
+
+      // explicit serialization macro is not necessary, used here only to improve compilation time
+      EOSLIB_SERIALIZE( producer_votes, (owner)(total_votes)(is_active) )
+   };
+
+   // Legacy voter info, superseded by `voter_info2`. Rows of the `voters` table are moved to the `voters2`
+   // table the first time they are touched. Voter info stores information about the voter:
    // - `owner` the voter
    // - `proxy` the proxy set by the voter, if any
    // - `producers` the producers approved by this voter if no proxy set
@@ -227,11 +275,76 @@ namespace eosiosystem {
 
    typedef eosio::multi_index< "voters"_n, voter_info >  voters_table;
 
+   // Compact voter info. It is rewritten on every stake change, so it only holds what the vote tally needs:
+   // - `version` defaulted to zero,
+   // - `owner` the voter
+   // - `proxy` the proxy set by the voter, if any
+   // - `producers` the producers approved by this voter if no proxy set
+   // - `staked` the amount staked
+   // - `last_vote_weight` the vote weight cast the last time the vote was updated
+   // - `flags1` the resource management flags and the proxy flag, see `flags1_fields`
+   // The vote weight delegated to a proxy is kept in the `proxies` table, see `proxy_info`.
+   struct [[eosio::table, eosio::contract("amax.system")]] voter_info2 {
+      uint8_t             version = 0;
+      name                owner;
+      name                proxy;
+      std::vector<name>   producers;
+      int64_t             staked = 0;
+      double              last_vote_weight = 0;
+      uint32_t            flags1 = 0;
+
+      uint64_t primary_key()const { return owner.value; }
+      bool     is_proxy()const    { return has_field( flags1, flags1_fields::is_proxy ); }
+
+      enum class flags1_fields : uint32_t {
+         ram_managed = 1,
+         net_managed = 2,
+         cpu_managed = 4,
+         is_proxy    = 0x80000000
+      };
+
+      // explicit serialization macro is not necessary, used here only to improve compilation time
+      EOSLIB_SERIALIZE( voter_info2, (version)(owner)(proxy)(producers)(staked)(last_vote_weight)(flags1) )
+   };
+
+   typedef eosio::multi_index< "voters2"_n, voter_info2 >  voters2_table;
 
+   // Proxy info, only exists for accounts that are or have been registered as a proxy:
+   // - `owner` the proxy
+   // - `proxied_vote_weight` the total vote weight delegated to this proxy
+   struct [[eosio::table, eosio::contract("amax.system")]] proxy_info {
+      name                owner;
+      double              proxied_vote_weight = 0;
+
+      uint64_t primary_key()const { return owner.value; }
+
+      // explicit serialization macro is not necessary, used here only to improve compilation time
+      EOSLIB_SERIALIZE( proxy_info, (owner)(proxied_vote_weight) )
+   };
+
+   typedef eosio::multi_index< "proxies"_n, proxy_info >  proxies_table;
+
+
+   // The `prototalvote` index is no longer read, it is kept so that its existing rows are maintained
+   // together with the `producers` rows instead of being left orphaned.
    typedef eosio::multi_index< "producers"_n, producer_info,
                                indexed_by<"prototalvote"_n, const_mem_fun<producer_info, double, &producer_info::by_votes>  >
                              > producers_table;
 
+   typedef eosio::multi_index< "prodvotes"_n, producer_votes,
+                               indexed_by<"prototalvote"_n, const_mem_fun<producer_votes, double, &producer_votes::by_votes>  >
+                             > producer_votes_table;
+
+   // `prodvotes_migration` keeps the progress of copying the vote tallies of `producers` rows into `prodvotes`:
+   // - `cursor` the owner of the next `producers` row to visit
+   // - `done` whether every `producers` row has its `prodvotes` row
+   struct [[eosio::table("prodvotemig"),eosio::contract("amax.system")]] prodvotes_migration {
+      name     cursor;
+      bool     done = false;
+   };
+
+   typedef eosio::singleton< "prodvotemig"_n, prodvotes_migration > prodvotes_migration_singleton;
+
    typedef eosio::singleton< "global"_n, amax_global_state >   global_state_singleton;
 
    struct [[eosio::table, eosio::contract("amax.system")]] user_resources {
@@ -276,9 +389,24 @@ namespace eosiosystem {
    };
 
 
+   // Global index of pending refunds ordered by request time, so that `processrefunds` can pay out
+   // matured refunds without knowing their owners. Mirrors the `refunds` row of `owner`.
+   struct [[eosio::table("refundqueue"), eosio::contract("amax.system")]] refund_maturity {
+      name            owner;
+      time_point_sec  request_time;
+
+      uint64_t  primary_key()const { return owner.value; }
+      uint128_t by_request_time()const { return (uint128_t(request_time.sec_since_epoch()) << 64) | owner.value; }
+
+      EOSLIB_SERIALIZE( refund_maturity, (owner)(request_time) )
+   };
+
    typedef eosio::multi_index< "userres"_n, user_resources >      user_resources_table;
    typedef eosio::multi_index< "delband"_n, delegated_bandwidth > del_bandwidth_table;
    typedef eosio::multi_index< "refunds"_n, refund_request >      refunds_table;
+   typedef eosio::multi_index< "refundqueue"_n, refund_maturity,
+                               indexed_by<"bytime"_n, const_mem_fun<refund_maturity, uint128_t, &refund_maturity::by_request_time>>
+                             > refund_queue_table;
 
    // `rex_pool` structure underlying the rex pool table. A rex pool table entry is defined by:
    // - `version` defaulted to zero,
@@ -331,17 +459,20 @@ namespace eosiosystem {
 
    typedef eosio::multi_index< "rexretpool"_n, rex_return_pool > rex_return_pool_table;
 
-   // `rex_return_buckets` structure underlying the rex return buckets table. A rex return buckets table is defined by:
+   // `rex_return_bucket` structure underlying the rex return bucket table, one row per 12-hour bucket of proceeds.
+   // A rex return bucket table entry is defined by:
    // - `version` defaulted to zero,
-   // - `return_buckets` buckets of proceeds accumulated in 12-hour intervals
-   struct [[eosio::table,eosio::contract("amax.system")]] rex_return_buckets {
-      uint8_t                           version = 0;
-      std::map<time_point_sec, int64_t> return_buckets;
+   // - `bucket_time` the time at which the bucket started contributing to the rex pool,
+   // - `rate_of_increase` the amount per dist_interval the bucket adds to the rex pool until it expires
+   struct [[eosio::table,eosio::contract("amax.system")]] rex_return_bucket {
+      uint8_t        version = 0;
+      time_point_sec bucket_time;
+      int64_t        rate_of_increase = 0;
 
-      uint64_t primary_key()const { return 0; }
+      uint64_t primary_key()const { return bucket_time.sec_since_epoch(); }
    };
 
-   typedef eosio::multi_index< "retbuckets"_n, rex_return_buckets > rex_return_buckets_table;
+   typedef eosio::multi_index< "retbucket"_n, rex_return_bucket > rex_return_bucket_table;
 
    // `rex_fund` structure underlying the rex fund table. A rex fund table entry is defined by:
    // - `version` defaulted to zero,
@@ -362,14 +493,21 @@ namespace eosiosystem {
    // - `owner` the owner of the rex fund,
    // - `vote_stake` the amount of CORE_SYMBOL currently included in owner's vote,
    // - `rex_balance` the amount of REX owned by owner,
-   // - `matured_rex` matured REX available for selling
+   // - `matured_rex` matured REX available for selling,
+   // - `maturity_day` index (days since epoch) of the earliest day not yet moved into `matured_rex`,
+   // - `maturity_slots` ring of `maturity_days` daily buckets, REX maturing on day `d` is kept in slot `d % maturity_days`,
+   // - `savings_rex` REX in savings, never matures until moved out with `mvfrsavings`
    struct [[eosio::table,eosio::contract("amax.system")]] rex_balance {
-      uint8_t version = 0;
-      name    owner;
-      asset   vote_stake;
-      asset   rex_balance;
-      int64_t matured_rex = 0;
-      std::deque<std::pair<time_point_sec, int64_t>> rex_maturities; /// REX daily maturity buckets
+      static constexpr uint32_t maturity_days = 5;
+
+      uint8_t              version = 0;
+      name                 owner;
+      asset                vote_stake;
+      asset                rex_balance;
+      int64_t              matured_rex = 0;
+      uint32_t             maturity_day = 0;
+      std::vector<int64_t> maturity_slots; /// always `maturity_days` long once touched
+      int64_t              savings_rex = 0;
 
       uint64_t primary_key()const { return owner.value; }
    };
@@ -434,6 +572,82 @@ namespace eosiosystem {
       asset stake_change;
    };
 
+   // `rex_queue_state` keeps the position of `runrex` in the `rexqueue` table between calls. `by_time` is not
+   // unique, so the position is the (`by_time`, `owner`) pair of the next sell order to visit:
+   // - `version` defaulted to zero,
+   // - `cursor` the `by_time` key of the next sell order, zero when the previous walk reached the end of open orders
+   // - `cursor_owner` the owner of the next sell order
+   struct [[eosio::table("rexqstate"),eosio::contract("amax.system")]] rex_queue_state {
+      uint8_t  version = 0;
+      uint64_t cursor  = 0;
+      name     cursor_owner;
+   };
+
+   typedef eosio::singleton< "rexqstate"_n, rex_queue_state > rex_queue_state_singleton;
+
+   // Work limits of a single `runrex` call. Each expired loan or sell order visited uses one step of
+   // its own queue budget and one step of the shared `steps` budget.
+   struct rex_run_budget {
+      uint16_t cpu_loans   = 0;
+      uint16_t net_loans   = 0;
+      uint16_t sell_orders = 0;
+      uint32_t steps       = 0;
+   };
+
+   // `vote_order` is one voter of a `votebatch`, like the arguments of `voteproducer`:
+   // - `voter` the account to change the voted producers for,
+   // - `proxy` the proxy to vote for, or empty,
+   // - `producers` the sorted list of at most 30 producers to vote for if `proxy` is empty
+   struct vote_order {
+      name              voter;
+      name              proxy;
+      std::vector<name> producers;
+
+      EOSLIB_SERIALIZE( vote_order, (voter)(proxy)(producers) )
+   };
+
+   static constexpr size_t max_vote_orders = 20;
+
+   // `buyram_order` is one receiver of a `buyrambatch` purchase, exactly one of `quant` and `bytes` is set:
+   // - `receiver` the account receiving the RAM,
+   // - `quant` the amount of core tokens to spend on RAM for the receiver,
+   // - `bytes` the amount of RAM to price the order with at the current market price, like `buyrambytes`
+   struct buyram_order {
+      name     receiver;
+      asset    quant;
+      uint32_t bytes = 0;
+
+      EOSLIB_SERIALIZE( buyram_order, (receiver)(quant)(bytes) )
+   };
+
+   static constexpr size_t max_buyram_orders = 100;
+
+   // `delegate_order` is one receiver of a `delegatebatch` stake:
+   // - `receiver` the account whose resources the staked tokens are added to,
+   // - `stake_net_quantity` tokens staked for NET bandwidth,
+   // - `stake_cpu_quantity` tokens staked for CPU bandwidth
+   struct delegate_order {
+      name     receiver;
+      asset    stake_net_quantity;
+      asset    stake_cpu_quantity;
+
+      EOSLIB_SERIALIZE( delegate_order, (receiver)(stake_net_quantity)(stake_cpu_quantity) )
+   };
+
+   static constexpr size_t max_delegate_orders = 100;
+
+   // `powerup_receiver` is one receiver of a `powerupmany` purchase:
+   // - `receiver` the account receiving the resources,
+   // - `net_frac` fraction of net (100% = 10^15) managed by the market,
+   // - `cpu_frac` fraction of cpu (100% = 10^15) managed by the market
+   struct powerup_receiver {
+      name     receiver;
+      int64_t  net_frac = 0;
+      int64_t  cpu_frac = 0;
+
+      EOSLIB_SERIALIZE( powerup_receiver, (receiver)(net_frac)(cpu_frac) )
+   };
+
    struct powerup_config_resource {
       std::optional<int64_t>        current_weight_ratio;   // Immediately set weight_ratio to this amount. 1x = 10^15. 0.01x = 10^13.
                                                             //    Do not specify to preserve the existing setting or use the default;
@@ -519,6 +733,25 @@ namespace eosiosystem {
       time_point_sec utilization_timestamp   = {};                 // When adjusted_utilization was last updated
    };
 
+   // Price curve of one resource, sampled by cfgpowerup for exponents without a closed form.
+   // Empty for exponents 1, 2 and 3.
+   struct powerup_price_table {
+      static constexpr uint32_t segments = 64;
+
+      std::vector<int64_t> prices;                                 // p(u) at u = i / segments, for i = 0..segments
+      std::vector<int64_t> integrals;                              // 2 * segments * f(u) of the linear interpolant of
+                                                                   //    `prices` at u = i / segments, for i = 0..segments
+
+      EOSLIB_SERIALIZE( powerup_price_table, (prices)(integrals) )
+   };
+
+   struct powerup_price_tables {
+      powerup_price_table net;
+      powerup_price_table cpu;
+
+      EOSLIB_SERIALIZE( powerup_price_tables, (net)(cpu) )
+   };
+
    struct [[eosio::table("powup.state"),eosio::contract("amax.system")]] powerup_state {
       static constexpr uint32_t default_powerup_days = 30; // 30 day resource powerups
 
@@ -527,6 +760,8 @@ namespace eosiosystem {
       powerup_state_resource     cpu               = {};                     // CPU market state
       uint32_t                   powerup_days      = default_powerup_days;   // `powerup` `days` argument must match this.
       asset                      min_powerup_fee   = {};                     // fees below this amount are rejected
+      binary_extension<powerup_price_tables> price_tables;                   // rebuilt by cfgpowerup; absent in states
+                                                                             //    configured before it was added
 
       uint64_t primary_key()const { return 0; }
    };
@@ -544,11 +779,18 @@ namespace eosiosystem {
       uint64_t primary_key()const { return id; }
       uint64_t by_owner()const    { return owner.value; }
       uint64_t by_expires()const  { return expires.utc_seconds; }
+      uint128_t by_owner_day()const { return owner_day_key( owner, expires ); }
+
+      // An order is an expiry bucket: all powerups for `owner` expiring on the same day share one row
+      static uint128_t owner_day_key( const name& owner, const time_point_sec& expires ) {
+         return (uint128_t(owner.value) << 64) | (expires.sec_since_epoch() / seconds_per_day);
+      }
    };
 
    typedef eosio::multi_index< "powup.order"_n, powerup_order,
                                indexed_by<"byowner"_n, const_mem_fun<powerup_order, uint64_t, &powerup_order::by_owner>>,
-                               indexed_by<"byexpires"_n, const_mem_fun<powerup_order, uint64_t, &powerup_order::by_expires>>
+                               indexed_by<"byexpires"_n, const_mem_fun<powerup_order, uint64_t, &powerup_order::by_expires>>,
+                               indexed_by<"byownerday"_n, const_mem_fun<powerup_order, uint128_t, &powerup_order::by_owner_day>>
                                > powerup_order_table;
 
    /**
@@ -568,14 +810,16 @@ namespace eosiosystem {
    class [[eosio::contract("amax.system")]] system_contract : public native {
 
       private:
-         voters_table             _voters;
+         voters2_table            _voters;
+         proxies_table            _proxies;
          producers_table          _producers;
+         producer_votes_table     _prodvotes;
          global_state_singleton   _global;
          amax_global_state       _gstate;
          rammarket                _rammarket;
          rex_pool_table           _rexpool;
          rex_return_pool_table    _rexretpool;
-         rex_return_buckets_table _rexretbuckets;
+         rex_return_bucket_table  _rexretbuckets;
          rex_fund_table           _rexfunds;
          rex_balance_table        _rexbalance;
          rex_order_table          _rexorders;
@@ -693,6 +937,19 @@ namespace eosiosystem {
          void delegatebw( const name& from, const name& receiver,
                           const asset& stake_net_quantity, const asset& stake_cpu_quantity, bool transfer );
 
+         /**
+          * Delegate bandwidth and/or cpu to many receivers at once. Stakes SYS from the balance of `from`
+          * like `delegatebw` without the transfer flag, but orders for the same receiver are merged so that each
+          * distinct receiver's resource limits are set once, and the voting power of `from` is updated once.
+          *
+          * @param from - the account holding the tokens to be staked,
+          * @param orders - at most `max_delegate_orders` receivers with the tokens staked for their NET and CPU bandwidth.
+          *
+          * @post All producers `from` account has voted for will have their votes updated immediately.
+          */
+         [[eosio::action]]
+         void delegatebatch( const name& from, const std::vector<delegate_order>& orders );
+
          /**
           * Setrex action, sets total_rent balance of REX pool to the passed value.
           * @param balance - amount to set the REX pool balance.
@@ -885,6 +1142,20 @@ namespace eosiosystem {
          [[eosio::action]]
          void rexexec( const name& user, uint16_t max );
 
+         /**
+          * Rexrun action, same as `rexexec` but with a separate budget for each queue and a total
+          * budget shared by all queues, so the work done by one call is bounded by `max_steps`.
+          * Sell orders are visited from where the previous call stopped.
+          *
+          * @param user - any account can execute this action,
+          * @param max_cpu_loans - maximum number of expired CPU loans to be processed,
+          * @param max_net_loans - maximum number of expired NET loans to be processed,
+          * @param max_sell_orders - maximum number of queued sellrex orders to be visited,
+          * @param max_steps - maximum number of loans and orders processed in total.
+          */
+         [[eosio::action]]
+         void rexrun( const name& user, uint16_t max_cpu_loans, uint16_t max_net_loans, uint16_t max_sell_orders, uint32_t max_steps );
+
          /**
           * Consolidate action, consolidates REX maturity buckets into one bucket that can be sold after 4 days
           * starting from the end of the day.
@@ -936,10 +1207,9 @@ namespace eosiosystem {
           * left to delegate.
           * This will cause an immediate reduction in net/cpu bandwidth of the
           * receiver.
-          * A transaction is scheduled to send the tokens back to `from` after
-          * the staking period has passed. If existing transaction is scheduled, it
-          * will be canceled and a new transaction issued that has the combined
-          * undelegated amount.
+          * The tokens are added to the pending refund of `from`, which can be paid
+          * out after the staking period has passed. If a refund is already pending,
+          * the combined undelegated amount is refunded at the end of the new period.
           * The `from` account loses voting power as a result of this call and
           * all producer tallies are updated.
           *
@@ -950,12 +1220,11 @@ namespace eosiosystem {
           * @param unstake_net_quantity - tokens to be unstaked from NET bandwidth,
           * @param unstake_cpu_quantity - tokens to be unstaked from CPU bandwidth,
           *
-          * @post Unstaked tokens are transferred to `from` liquid balance via a
-          *    deferred transaction with a delay of 3 days.
+          * @post Unstaked tokens are transferred to `from` liquid balance by `processrefunds`
+          *    or `refund` after a delay of 3 days.
           * @post If called during the delay period of a previous `undelegatebw`
-          *    action, pending action is canceled and timer is reset.
+          *    action, the timer is reset.
           * @post All producers `from` account has voted for will have their votes updated immediately.
-          * @post Bandwidth and storage for the deferred transaction are billed to `from`.
           */
          [[eosio::action]]
          void undelegatebw( const name& from, const name& receiver,
@@ -984,6 +1253,24 @@ namespace eosiosystem {
          [[eosio::action]]
          void buyrambytes( const name& payer, const name& receiver, uint32_t bytes );
 
+         /**
+          * Buy ram for many receivers action. The payment of all orders is transferred and converted
+          * on the RAM market at once, and the purchased bytes are split among the orders in proportion
+          * to what each of them paid. Every order pays the same 0.5% fee as a single `buyram`.
+          *
+          * An order given in `bytes` pays what `buyrambytes` would charge for them at the current price,
+          * but like every other order it receives its pro-rata share of the bytes bought by the batch.
+          * Since the batch moves the price more than each order alone, that share can be slightly less
+          * than the bytes asked for.
+          *
+          * @pre At most `max_buyram_orders` orders.
+          *
+          * @param payer - the ram buyer,
+          * @param orders - the receivers and the quantity of tokens or bytes bought for each of them.
+          */
+         [[eosio::action]]
+         void buyrambatch( const name& payer, const std::vector<buyram_order>& orders );
+
          /**
           * Sell ram action, reduces quota by bytes and then performs an inline transfer of tokens
           * to receiver based upon the average purchase price of the original quota.
@@ -1003,6 +1290,26 @@ namespace eosiosystem {
          [[eosio::action]]
          void refund( const name& owner );
 
+         /**
+          * Process refunds action, pays out up to `max` refunds whose delegation-period has elapsed,
+          * oldest first. Any account can execute this action. Matured refunds are not returned on their
+          * own, they are paid out by this action or by `refund`.
+          *
+          * @param max - the maximum number of refunds to pay out.
+          */
+         [[eosio::action]]
+         void processrefunds( uint16_t max );
+
+         /**
+          * Queue refunds action, adds the pending refunds of `owners` requested before the refund queue
+          * existed to the queue, so that `processrefunds` pays them out. Owners without a pending refund
+          * or already queued are skipped. Any account can execute this action.
+          *
+          * @param owners - at most `max_queued_refunds` owners of pending refunds.
+          */
+         [[eosio::action]]
+         void queuerefunds( const std::vector<name>& owners );
+
          // functions defined in voting.cpp
 
          /**
@@ -1089,6 +1396,17 @@ namespace eosiosystem {
          [[eosio::action]]
          void voteproducer( const name& voter, const name& proxy, const std::vector<name>& producers );
 
+         /**
+          * Vote batch action, changes the votes of many voters at once, each exactly like `voteproducer`.
+          * The producer vote changes of all voters are merged so that every affected producer is updated once.
+          * Every voter must authorize this action.
+          *
+          * @param votes - at most `max_vote_orders` voters with the proxy or sorted list of at most 30 producers
+          *    each votes for.
+          */
+         [[eosio::action]]
+         void votebatch( const std::vector<vote_order>& votes );
+
          /**
           * Register proxy action, sets `proxy` account as proxy.
           * An account marked as a proxy can vote with the weight of other accounts which
@@ -1140,11 +1458,26 @@ namespace eosiosystem {
           * @param revision - it has to be incremented by 1 compared with current revision.
           *
           * @pre Current revision can not be higher than 254, and has to be smaller
-          * than or equal 1 (“set upper bound to greatest revision supported in the code”).
+          * than or equal 2 (“set upper bound to greatest revision supported in the code”).
+          *
+          * @post Revision 2 starts copying the vote tallies of producers registered before the `prodvotes`
+          * table existed into that table, see `migrateprods`.
           */
          [[eosio::action]]
          void updtrevision( uint8_t revision );
 
+         /**
+          * Migrate producers action, copies the vote tallies of up to `max` producers registered before the
+          * `prodvotes` table existed into that table. Any account can execute this action.
+          *
+          * A producer is also migrated the first time its votes change, and every producer schedule update
+          * migrates a bounded batch; the schedule is not updated until the migration is done.
+          *
+          * @param max - the maximum number of `producers` rows to visit.
+          */
+         [[eosio::action]]
+         void migrateprods( uint16_t max );
+
          /**
           * Bid name action, allows an account `bidder` to place a bid for a name `newname`.
           * @param bidder - the account placing the bid,
@@ -1173,6 +1506,23 @@ namespace eosiosystem {
          [[eosio::action]]
          void bidrefund( const name& bidder, const name& newname );
 
+         /**
+          * Bid withdraw action, allows the account `bidder` to get back at once everything it has been
+          * outbid with across all name auctions.
+          *
+          * @param bidder - the account that gets refunded.
+          */
+         [[eosio::action]]
+         void bidwithdraw( const name& bidder );
+
+         /**
+          * Configure name auctions.
+          *
+          * @param max_closes_per_day - the maximum number of matured auctions closed at once each day, at least 1.
+          */
+         [[eosio::action]]
+         void cfgnamebid( uint16_t max_closes_per_day );
+
          /**
           * Set inflation Parameters
           * Only be set after contract init() and before inflation start.
@@ -1213,12 +1563,26 @@ namespace eosiosystem {
          [[eosio::action]]
          void powerup( const name& payer, const name& receiver, uint32_t days, int64_t net_frac, int64_t cpu_frac, const asset& max_payment );
 
+         /**
+          * Powerup NET and CPU resources for many receivers at once, for the market's configured number of days.
+          * The total utilization increase is priced along the curve once and the fee is split among
+          * the receivers pro-rata to the resources each one gets.
+          *
+          * @param payer - the resource buyer
+          * @param receivers - the resource receivers with their net and cpu fractions
+          * @param max_payment - the maximum total amount `payer` is willing to pay. Tokens are withdrawn from
+          *    `payer`'s token balance.
+          */
+         [[eosio::action]]
+         void powerupmany( const name& payer, const std::vector<powerup_receiver>& receivers, const asset& max_payment );
+
          using init_action = eosio::action_wrapper<"init"_n, &system_contract::init>;
          using setacctram_action = eosio::action_wrapper<"setacctram"_n, &system_contract::setacctram>;
          using setacctnet_action = eosio::action_wrapper<"setacctnet"_n, &system_contract::setacctnet>;
          using setacctcpu_action = eosio::action_wrapper<"setacctcpu"_n, &system_contract::setacctcpu>;
          using activate_action = eosio::action_wrapper<"activate"_n, &system_contract::activate>;
          using delegatebw_action = eosio::action_wrapper<"delegatebw"_n, &system_contract::delegatebw>;
+         using delegatebatch_action = eosio::action_wrapper<"delegatebatch"_n, &system_contract::delegatebatch>;
          using deposit_action = eosio::action_wrapper<"deposit"_n, &system_contract::deposit>;
          using withdraw_action = eosio::action_wrapper<"withdraw"_n, &system_contract::withdraw>;
          using buyrex_action = eosio::action_wrapper<"buyrex"_n, &system_contract::buyrex>;
@@ -1233,6 +1597,7 @@ namespace eosiosystem {
          using defnetloan_action = eosio::action_wrapper<"defnetloan"_n, &system_contract::defnetloan>;
          using updaterex_action = eosio::action_wrapper<"updaterex"_n, &system_contract::updaterex>;
          using rexexec_action = eosio::action_wrapper<"rexexec"_n, &system_contract::rexexec>;
+         using rexrun_action = eosio::action_wrapper<"rexrun"_n, &system_contract::rexrun>;
          using setrex_action = eosio::action_wrapper<"setrex"_n, &system_contract::setrex>;
          using mvtosavings_action = eosio::action_wrapper<"mvtosavings"_n, &system_contract::mvtosavings>;
          using mvfrsavings_action = eosio::action_wrapper<"mvfrsavings"_n, &system_contract::mvfrsavings>;
@@ -1241,20 +1606,27 @@ namespace eosiosystem {
          using undelegatebw_action = eosio::action_wrapper<"undelegatebw"_n, &system_contract::undelegatebw>;
          using buyram_action = eosio::action_wrapper<"buyram"_n, &system_contract::buyram>;
          using buyrambytes_action = eosio::action_wrapper<"buyrambytes"_n, &system_contract::buyrambytes>;
+         using buyrambatch_action = eosio::action_wrapper<"buyrambatch"_n, &system_contract::buyrambatch>;
          using sellram_action = eosio::action_wrapper<"sellram"_n, &system_contract::sellram>;
          using refund_action = eosio::action_wrapper<"refund"_n, &system_contract::refund>;
+         using processrefunds_action = eosio::action_wrapper<"processrefunds"_n, &system_contract::processrefunds>;
+         using queuerefunds_action = eosio::action_wrapper<"queuerefunds"_n, &system_contract::queuerefunds>;
          using regproducer_action = eosio::action_wrapper<"regproducer"_n, &system_contract::regproducer>;
          using regproducer2_action = eosio::action_wrapper<"regproducer2"_n, &system_contract::regproducer2>;
          using unregprod_action = eosio::action_wrapper<"unregprod"_n, &system_contract::unregprod>;
          using setram_action = eosio::action_wrapper<"setram"_n, &system_contract::setram>;
          using setramrate_action = eosio::action_wrapper<"setramrate"_n, &system_contract::setramrate>;
          using voteproducer_action = eosio::action_wrapper<"voteproducer"_n, &system_contract::voteproducer>;
+         using votebatch_action = eosio::action_wrapper<"votebatch"_n, &system_contract::votebatch>;
          using regproxy_action = eosio::action_wrapper<"regproxy"_n, &system_contract::regproxy>;
          using claimrewards_action = eosio::action_wrapper<"claimrewards"_n, &system_contract::claimrewards>;
          using rmvproducer_action = eosio::action_wrapper<"rmvproducer"_n, &system_contract::rmvproducer>;
          using updtrevision_action = eosio::action_wrapper<"updtrevision"_n, &system_contract::updtrevision>;
+         using migrateprods_action = eosio::action_wrapper<"migrateprods"_n, &system_contract::migrateprods>;
          using bidname_action = eosio::action_wrapper<"bidname"_n, &system_contract::bidname>;
          using bidrefund_action = eosio::action_wrapper<"bidrefund"_n, &system_contract::bidrefund>;
+         using bidwithdraw_action = eosio::action_wrapper<"bidwithdraw"_n, &system_contract::bidwithdraw>;
+         using cfgnamebid_action = eosio::action_wrapper<"cfgnamebid"_n, &system_contract::cfgnamebid>;
          using setpriv_action = eosio::action_wrapper<"setpriv"_n, &system_contract::setpriv>;
          using setalimits_action = eosio::action_wrapper<"setalimits"_n, &system_contract::setalimits>;
          using setparams_action = eosio::action_wrapper<"setparams"_n, &system_contract::setparams>;
@@ -1262,6 +1634,7 @@ namespace eosiosystem {
          using cfgpowerup_action = eosio::action_wrapper<"cfgpowerup"_n, &system_contract::cfgpowerup>;
          using powerupexec_action = eosio::action_wrapper<"powerupexec"_n, &system_contract::powerupexec>;
          using powerup_action = eosio::action_wrapper<"powerup"_n, &system_contract::powerup>;
+         using powerupmany_action = eosio::action_wrapper<"powerupmany"_n, &system_contract::powerupmany>;
 
       private:
          //defined in amax.system.cpp
@@ -1273,10 +1646,11 @@ namespace eosiosystem {
 
          // defined in rex.cpp
          void runrex( uint16_t max );
+         void runrex( const rex_run_budget& budget );
          void update_rex_pool();
          void update_resource_limits( const name& from, const name& receiver, int64_t delta_net, int64_t delta_cpu );
          void check_voting_requirement( const name& owner,
-                                        const char* error_msg = "must vote for at least 21 producers or for a proxy before buying REX" )const;
+                                        const char* error_msg = "must vote for at least 21 producers or for a proxy before buying REX" );
          rex_order_outcome fill_rex_order( const rex_balance_table::const_iterator& bitr, const asset& rex );
          asset update_rex_account( const name& owner, const asset& proceeds, const asset& unstake_quant, bool force_vote_update = false );
          void channel_to_rex( const name& from, const asset& amount, bool required = false );
@@ -1301,6 +1675,8 @@ namespace eosiosystem {
                                        const asset& rex_in_sell_order );
          int64_t read_rex_savings( const rex_balance_table::const_iterator& bitr );
          void put_rex_savings( const rex_balance_table::const_iterator& bitr, int64_t rex );
+         static void advance_rex_maturities( rex_balance& rb );
+         static void add_rex_maturity( rex_balance& rb, int64_t rex );
          void update_rex_stake( const name& voter );
 
          void add_loan_to_rex_pool( const asset& payment, int64_t rented_tokens, bool new_loan );
@@ -1309,15 +1685,34 @@ namespace eosiosystem {
          int64_t update_renewed_loan( Index& idx, const Iterator& itr, int64_t rented_tokens );
 
          // defined in delegate_bandwidth.cpp
+         int64_t get_ram_bytes_cost( uint32_t bytes )const;
+         void add_ram_bytes( const name& receiver, int64_t bytes );
          void changebw( name from, const name& receiver,
                         const asset& stake_net_quantity, const asset& stake_cpu_quantity, bool transfer );
+         void update_delband( const name& from, const name& receiver,
+                              const asset& stake_net_delta, const asset& stake_cpu_delta );
+         void update_user_resources( const name& payer, const name& receiver,
+                                     const asset& stake_net_delta, const asset& stake_cpu_delta );
+         asset update_refund( const name& from, const asset& stake_net_delta, const asset& stake_cpu_delta,
+                              bool use_refund );
+         void update_refund_queue( const name& owner, const refund_request* req );
          void update_voting_power( const name& voter, const asset& total_update );
 
          // defined in voting.cpp
          void register_producer( const name& producer, const eosio::block_signing_authority& producer_authority, const std::string& url, uint16_t location );
          void update_elected_producers( const block_timestamp& timestamp );
+         bool migrate_producer_votes( uint16_t max );
+         producer_votes_table::const_iterator find_producer_votes( const name& producer );
+         // producer -> ( vote weight delta, whether the producer is in a new vote )
+         using producer_deltas_map = std::map<name, std::pair<double, bool>>;
          void update_votes( const name& voter, const name& proxy, const std::vector<name>& producers, bool voting );
-         void propagate_weight_change( const voter_info& voter );
+         void update_votes( const name& voter, const name& proxy, const std::vector<name>& producers, bool voting,
+                            producer_deltas_map& producer_deltas );
+         void apply_producer_deltas( const producer_deltas_map& producer_deltas, bool voting );
+         void propagate_weight_change( const voter_info2& voter );
+         voters2_table::const_iterator find_voter( const name& owner );
+         double get_proxied_vote_weight( const name& proxy )const;
+         void add_proxied_vote_weight( const name& proxy, double delta );
 
          template <auto system_contract::*...Ptrs>
          class registration {
@@ -1357,6 +1752,8 @@ namespace eosiosystem {
             time_point_sec now, symbol core_symbol, powerup_state& state,
             powerup_order_table& orders, uint32_t max_items, int64_t& net_delta_available,
             int64_t& cpu_delta_available);
+         void add_powerup_order(powerup_order_table& orders, const name& payer, const name& receiver, int64_t net_weight,
+                                int64_t cpu_weight, time_point_sec expires);
    };
 
 }
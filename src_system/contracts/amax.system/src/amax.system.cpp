@@ -14,7 +14,9 @@ namespace eosiosystem {
    system_contract::system_contract( name s, name code, datastream<const char*> ds )
    :native(s,code,ds),
     _voters(get_self(), get_self().value),
+    _proxies(get_self(), get_self().value),
     _producers(get_self(), get_self().value),
+    _prodvotes(get_self(), get_self().value),
     _global(get_self(), get_self().value),
     _rammarket(get_self(), get_self().value),
     _rexpool(get_self(), get_self().value),
@@ -114,11 +116,11 @@ namespace eosiosystem {
       auto ritr = userres.find( account.value );
       check( ritr == userres.end(), "only supports unlimited accounts" );
 
-      auto vitr = _voters.find( account.value );
+      auto vitr = find_voter( account );
       if( vitr != _voters.end() ) {
-         bool ram_managed = has_field( vitr->flags1, voter_info::flags1_fields::ram_managed );
-         bool net_managed = has_field( vitr->flags1, voter_info::flags1_fields::net_managed );
-         bool cpu_managed = has_field( vitr->flags1, voter_info::flags1_fields::cpu_managed );
+         bool ram_managed = has_field( vitr->flags1, voter_info2::flags1_fields::ram_managed );
+         bool net_managed = has_field( vitr->flags1, voter_info2::flags1_fields::net_managed );
+         bool cpu_managed = has_field( vitr->flags1, voter_info2::flags1_fields::cpu_managed );
          check( !(ram_managed || net_managed || cpu_managed), "cannot use setalimits on an account with managed resources" );
       }
 
@@ -134,8 +136,8 @@ namespace eosiosystem {
       int64_t ram = 0;
 
       if( !ram_bytes ) {
-         auto vitr = _voters.find( account.value );
-         check( vitr != _voters.end() && has_field( vitr->flags1, voter_info::flags1_fields::ram_managed ),
+         auto vitr = find_voter( account );
+         check( vitr != _voters.end() && has_field( vitr->flags1, voter_info2::flags1_fields::ram_managed ),
                 "RAM of account is already unmanaged" );
 
          user_resources_table userres( get_self(), account.value );
@@ -147,20 +149,20 @@ namespace eosiosystem {
          }
 
          _voters.modify( vitr, same_payer, [&]( auto& v ) {
-            v.flags1 = set_field( v.flags1, voter_info::flags1_fields::ram_managed, false );
+            v.flags1 = set_field( v.flags1, voter_info2::flags1_fields::ram_managed, false );
          });
       } else {
          check( *ram_bytes >= 0, "not allowed to set RAM limit to unlimited" );
 
-         auto vitr = _voters.find( account.value );
+         auto vitr = find_voter( account );
          if ( vitr != _voters.end() ) {
             _voters.modify( vitr, same_payer, [&]( auto& v ) {
-               v.flags1 = set_field( v.flags1, voter_info::flags1_fields::ram_managed, true );
+               v.flags1 = set_field( v.flags1, voter_info2::flags1_fields::ram_managed, true );
             });
          } else {
             _voters.emplace( account, [&]( auto& v ) {
                v.owner  = account;
-               v.flags1 = set_field( v.flags1, voter_info::flags1_fields::ram_managed, true );
+               v.flags1 = set_field( v.flags1, voter_info2::flags1_fields::ram_managed, true );
             });
          }
 
@@ -179,8 +181,8 @@ namespace eosiosystem {
       int64_t net = 0;
 
       if( !net_weight ) {
-         auto vitr = _voters.find( account.value );
-         check( vitr != _voters.end() && has_field( vitr->flags1, voter_info::flags1_fields::net_managed ),
+         auto vitr = find_voter( account );
+         check( vitr != _voters.end() && has_field( vitr->flags1, voter_info2::flags1_fields::net_managed ),
                 "Network bandwidth of account is already unmanaged" );
 
          user_resources_table userres( get_self(), account.value );
@@ -191,20 +193,20 @@ namespace eosiosystem {
          }
 
          _voters.modify( vitr, same_payer, [&]( auto& v ) {
-            v.flags1 = set_field( v.flags1, voter_info::flags1_fields::net_managed, false );
+            v.flags1 = set_field( v.flags1, voter_info2::flags1_fields::net_managed, false );
          });
       } else {
          check( *net_weight >= -1, "invalid value for net_weight" );
 
-         auto vitr = _voters.find( account.value );
+         auto vitr = find_voter( account );
          if ( vitr != _voters.end() ) {
             _voters.modify( vitr, same_payer, [&]( auto& v ) {
-               v.flags1 = set_field( v.flags1, voter_info::flags1_fields::net_managed, true );
+               v.flags1 = set_field( v.flags1, voter_info2::flags1_fields::net_managed, true );
             });
          } else {
             _voters.emplace( account, [&]( auto& v ) {
                v.owner  = account;
-               v.flags1 = set_field( v.flags1, voter_info::flags1_fields::net_managed, true );
+               v.flags1 = set_field( v.flags1, voter_info2::flags1_fields::net_managed, true );
             });
          }
 
@@ -223,8 +225,8 @@ namespace eosiosystem {
       int64_t cpu = 0;
 
       if( !cpu_weight ) {
-         auto vitr = _voters.find( account.value );
-         check( vitr != _voters.end() && has_field( vitr->flags1, voter_info::flags1_fields::cpu_managed ),
+         auto vitr = find_voter( account );
+         check( vitr != _voters.end() && has_field( vitr->flags1, voter_info2::flags1_fields::cpu_managed ),
                 "CPU bandwidth of account is already unmanaged" );
 
          user_resources_table userres( get_self(), account.value );
@@ -235,20 +237,20 @@ namespace eosiosystem {
          }
 
          _voters.modify( vitr, same_payer, [&]( auto& v ) {
-            v.flags1 = set_field( v.flags1, voter_info::flags1_fields::cpu_managed, false );
+            v.flags1 = set_field( v.flags1, voter_info2::flags1_fields::cpu_managed, false );
          });
       } else {
          check( *cpu_weight >= -1, "invalid value for cpu_weight" );
 
-         auto vitr = _voters.find( account.value );
+         auto vitr = find_voter( account );
          if ( vitr != _voters.end() ) {
             _voters.modify( vitr, same_payer, [&]( auto& v ) {
-               v.flags1 = set_field( v.flags1, voter_info::flags1_fields::cpu_managed, true );
+               v.flags1 = set_field( v.flags1, voter_info2::flags1_fields::cpu_managed, true );
             });
          } else {
             _voters.emplace( account, [&]( auto& v ) {
                v.owner  = account;
-               v.flags1 = set_field( v.flags1, voter_info::flags1_fields::cpu_managed, true );
+               v.flags1 = set_field( v.flags1, voter_info2::flags1_fields::cpu_managed, true );
             });
          }
 
@@ -265,14 +267,23 @@ namespace eosiosystem {
       _producers.modify( prod, same_payer, [&](auto& p) {
             p.deactivate();
          });
+      auto pv = find_producer_votes( producer );
+      if ( pv != _prodvotes.end() ) {
+         _prodvotes.modify( pv, same_payer, [&](auto& p) {
+               p.is_active = false;
+            });
+      }
    }
 
    void system_contract::updtrevision( uint8_t revision ) {
       require_auth( get_self() );
       check( _gstate.revision < 255, "can not increment revision" ); // prevent wrap around
       check( revision == _gstate.revision + 1, "can only increment revision by one" );
-      check( revision <= 1, // set upper bound to greatest revision supported in the code
+      check( revision <= 2, // set upper bound to greatest revision supported in the code
              "specified revision is not yet supported by the code" );
+      if ( revision == 2 ) {
+         migrate_producer_votes( max_prodvotes_migration_per_schedule );
+      }
       _gstate.revision = revision;
    }
 
@@ -372,6 +383,12 @@ namespace eosiosystem {
       
       _gstate.core_symbol = core;
 
+      // every producer registered from now on gets its `prodvotes` row in `regproducer`
+      prodvotes_migration_singleton prodvotes_mig( get_self(), get_self().value );
+      prodvotes_migration mig;
+      mig.done = true;
+      prodvotes_mig.set( mig, get_self() );
+
       _rammarket.emplace( get_self(), [&]( auto& m ) {
          m.supply.amount = 100000000000000ll;
          m.supply.symbol = ramcore_symbol;
@@ -18,17 +18,25 @@ namespace eosiosystem {
    using eosio::seconds;
    using eosio::time_point_sec;
    using eosio::token;
+   using eosio::transfer_order;
 
    /**
     *  This action will buy an exact amount of ram and bill the payer the current market price.
     */
    void system_contract::buyrambytes( const name& payer, const name& receiver, uint32_t bytes ) {
+      buyram( payer, receiver, asset{ get_ram_bytes_cost( bytes ), core_symbol() } );
+   }
+
+   /**
+    *  Returns the amount of core tokens, fee included, that buys `bytes` of RAM at the current market price.
+    */
+   int64_t system_contract::get_ram_bytes_cost( uint32_t bytes )const {
       auto itr = _rammarket.find(ramcore_symbol.raw());
       const int64_t ram_reserve   = itr->base.balance.amount;
       const int64_t eos_reserve   = itr->quote.balance.amount;
       const int64_t cost          = exchange_state::get_bancor_input( ram_reserve, eos_reserve, bytes );
       const int64_t cost_plus_fee = cost / double(0.995);
-      buyram( payer, receiver, asset{ cost_plus_fee, core_symbol() } );
+      return cost_plus_fee;
    }
 
 
@@ -84,6 +92,83 @@ namespace eosiosystem {
       _gstate.total_ram_bytes_reserved += uint64_t(bytes_out);
       _gstate.total_ram_stake          += quant_after_fee.amount;
 
+      add_ram_bytes( receiver, bytes_out );
+   }
+
+   void system_contract::buyrambatch( const name& payer, const std::vector<buyram_order>& orders )
+   {
+      check( !token::is_blacklisted("amax.token"_n, payer), "blacklisted" );
+
+      require_auth( payer );
+      check( !orders.empty(), "no orders" );
+      check( orders.size() <= max_buyram_orders, "too many orders" );
+      update_ram_supply();
+
+      /// price every order the way a single `buyram` / `buyrambytes` would, fee included
+      const auto& core_sym = core_symbol();
+      std::vector<int64_t> paid;
+      paid.reserve( orders.size() );
+      asset fee{ 0, core_sym };
+      asset quant_after_fee{ 0, core_sym };
+      for ( const auto& o : orders ) {
+         check( is_account( o.receiver ), "receiver account does not exist" );
+         check( (o.bytes > 0) != (o.quant.amount != 0), "exactly one of quant and bytes must be set" );
+         int64_t quant = o.quant.amount;
+         if ( o.bytes > 0 ) {
+            quant = get_ram_bytes_cost( o.bytes );
+         } else {
+            check( o.quant.symbol == core_sym, "must buy ram with core token" );
+            check( o.quant.amount > 0, "must purchase a positive amount" );
+         }
+         const int64_t order_fee = ( quant + 199 ) / 200; /// .5% fee (round up)
+         check( quant - order_fee > 0, "must purchase a positive amount" );
+         paid.push_back( quant - order_fee );
+         fee             += asset( order_fee, core_sym );
+         quant_after_fee += asset( quant - order_fee, core_sym );
+      }
+
+      {
+         token::transfer_action transfer_act{ token_account, { {payer, active_permission}, {ram_account, active_permission} } };
+         transfer_act.send( payer, ram_account, quant_after_fee, "buy ram" );
+      }
+      {
+         token::transfer_action transfer_act{ token_account, { {payer, active_permission} } };
+         transfer_act.send( payer, ramfee_account, fee, "ram fee" );
+         channel_to_rex( ramfee_account, fee );
+      }
+
+      int64_t bytes_out;
+
+      const auto& market = _rammarket.get(ramcore_symbol.raw(), "ram market does not exist");
+      _rammarket.modify( market, same_payer, [&]( auto& es ) {
+         bytes_out = es.direct_convert( quant_after_fee,  ram_symbol ).amount;
+      });
+
+      _gstate.total_ram_bytes_reserved += uint64_t(bytes_out);
+      _gstate.total_ram_stake          += quant_after_fee.amount;
+
+      /// split the bytes in proportion to the payment, rounding dust goes to the last order
+      std::map<name, int64_t> bytes_by_receiver;
+      int64_t allotted = 0;
+      for ( size_t i = 0; i < orders.size(); ++i ) {
+         const int64_t bytes = ( i + 1 == orders.size() )
+                               ? bytes_out - allotted
+                               : int64_t( ( uint128_t(bytes_out) * paid[i] ) / quant_after_fee.amount );
+         check( bytes > 0, "must reserve a positive amount" );
+         allotted += bytes;
+         bytes_by_receiver[orders[i].receiver] += bytes;
+      }
+
+      for ( const auto& rb : bytes_by_receiver ) {
+         add_ram_bytes( rb.first, rb.second );
+      }
+   }
+
+   /**
+    *  Adds purchased RAM to the receiver's quota and, unless RAM of the receiver is managed, to its resource limits.
+    */
+   void system_contract::add_ram_bytes( const name& receiver, int64_t bytes_out )
+   {
       user_resources_table  userres( get_self(), receiver.value );
       auto res_itr = userres.find( receiver.value );
       if( res_itr ==  userres.end() ) {
@@ -99,8 +184,8 @@ namespace eosiosystem {
             });
       }
 
-      auto voter_itr = _voters.find( res_itr->owner.value );
-      if( voter_itr == _voters.end() || !has_field( voter_itr->flags1, voter_info::flags1_fields::ram_managed ) ) {
+      auto voter_itr = find_voter( res_itr->owner );
+      if( voter_itr == _voters.end() || !has_field( voter_itr->flags1, voter_info2::flags1_fields::ram_managed ) ) {
          int64_t ram_bytes, net, cpu;
          get_resource_limits( res_itr->owner, ram_bytes, net, cpu );
          set_resource_limits( res_itr->owner, res_itr->ram_bytes + ram_gift_bytes, net, cpu );
@@ -145,8 +230,8 @@ namespace eosiosystem {
           res.ram_bytes -= bytes;
       });
 
-      auto voter_itr = _voters.find( res_itr->owner.value );
-      if( voter_itr == _voters.end() || !has_field( voter_itr->flags1, voter_info::flags1_fields::ram_managed ) ) {
+      auto voter_itr = find_voter( res_itr->owner );
+      if( voter_itr == _voters.end() || !has_field( voter_itr->flags1, voter_info2::flags1_fields::ram_managed ) ) {
          int64_t ram_bytes, net, cpu;
          get_resource_limits( res_itr->owner, ram_bytes, net, cpu );
          set_resource_limits( res_itr->owner, res_itr->ram_bytes + ram_gift_bytes, net, cpu );
@@ -181,172 +266,197 @@ namespace eosiosystem {
       }
 
       // update stake delegated from "from" to "receiver"
-      {
-         del_bandwidth_table     del_tbl( get_self(), from.value );
-         auto itr = del_tbl.find( receiver.value );
-         if( itr == del_tbl.end() ) {
-            itr = del_tbl.emplace( from, [&]( auto& dbo ){
-                  dbo.from          = from;
-                  dbo.to            = receiver;
-                  dbo.net_weight    = stake_net_delta;
-                  dbo.cpu_weight    = stake_cpu_delta;
-               });
-         }
-         else {
-            del_tbl.modify( itr, same_payer, [&]( auto& dbo ){
-                  dbo.net_weight    += stake_net_delta;
-                  dbo.cpu_weight    += stake_cpu_delta;
-               });
-         }
-         check( 0 <= itr->net_weight.amount, "insufficient staked net bandwidth" );
-         check( 0 <= itr->cpu_weight.amount, "insufficient staked cpu bandwidth" );
-         if ( itr->is_empty() ) {
-            del_tbl.erase( itr );
-         }
-      } // itr can be invalid, should go out of scope
+      update_delband( from, receiver, stake_net_delta, stake_cpu_delta );
 
       // update totals of "receiver"
-      {
-         user_resources_table   totals_tbl( get_self(), receiver.value );
-         auto tot_itr = totals_tbl.find( receiver.value );
-         if( tot_itr ==  totals_tbl.end() ) {
-            tot_itr = totals_tbl.emplace( from, [&]( auto& tot ) {
-                  tot.owner = receiver;
-                  tot.net_weight    = stake_net_delta;
-                  tot.cpu_weight    = stake_cpu_delta;
-               });
-         } else {
-            totals_tbl.modify( tot_itr, from == receiver ? from : same_payer, [&]( auto& tot ) {
-                  tot.net_weight    += stake_net_delta;
-                  tot.cpu_weight    += stake_cpu_delta;
-               });
+      update_user_resources( from, receiver, stake_net_delta, stake_cpu_delta );
+
+      // create refund or update from existing refund
+      if ( stake_account != source_stake_from ) { //for eosio both transfer and refund make no sense
+         // net and cpu are same sign by assertions in delegatebw and undelegatebw
+         // redundant assertion also at start of changebw to protect against misuse of changebw
+         bool is_undelegating = (stake_net_delta.amount + stake_cpu_delta.amount ) < 0;
+         bool is_delegating_to_self = (!transfer && from == receiver);
+
+         auto transfer_amount = update_refund( from, stake_net_delta, stake_cpu_delta,
+                                               is_delegating_to_self || is_undelegating );
+         if ( 0 < transfer_amount.amount ) {
+            token::transfer_action transfer_act{ token_account, { {source_stake_from, active_permission} } };
+            transfer_act.send( source_stake_from, stake_account, asset(transfer_amount), "stake bandwidth" );
          }
-         check( 0 <= tot_itr->net_weight.amount, "insufficient staked total net bandwidth" );
-         check( 0 <= tot_itr->cpu_weight.amount, "insufficient staked total cpu bandwidth" );
-
-         {
-            bool ram_managed = false;
-            bool net_managed = false;
-            bool cpu_managed = false;
-
-            auto voter_itr = _voters.find( receiver.value );
-            if( voter_itr != _voters.end() ) {
-               ram_managed = has_field( voter_itr->flags1, voter_info::flags1_fields::ram_managed );
-               net_managed = has_field( voter_itr->flags1, voter_info::flags1_fields::net_managed );
-               cpu_managed = has_field( voter_itr->flags1, voter_info::flags1_fields::cpu_managed );
-            }
+      }
 
-            if( !(net_managed && cpu_managed) ) {
-               int64_t ram_bytes, net, cpu;
-               get_resource_limits( receiver, ram_bytes, net, cpu );
+      vote_stake_updater( from );
+      update_voting_power( from, stake_net_delta + stake_cpu_delta );
+   }
 
-               set_resource_limits( receiver,
-                                    ram_managed ? ram_bytes : std::max( tot_itr->ram_bytes + ram_gift_bytes, ram_bytes ),
-                                    net_managed ? net : tot_itr->net_weight.amount,
-                                    cpu_managed ? cpu : tot_itr->cpu_weight.amount );
-            }
+   void system_contract::update_delband( const name& from, const name& receiver,
+                                         const asset& stake_net_delta, const asset& stake_cpu_delta )
+   {
+      del_bandwidth_table     del_tbl( get_self(), from.value );
+      auto itr = del_tbl.find( receiver.value );
+      if( itr == del_tbl.end() ) {
+         itr = del_tbl.emplace( from, [&]( auto& dbo ){
+               dbo.from          = from;
+               dbo.to            = receiver;
+               dbo.net_weight    = stake_net_delta;
+               dbo.cpu_weight    = stake_cpu_delta;
+            });
+      }
+      else {
+         del_tbl.modify( itr, same_payer, [&]( auto& dbo ){
+               dbo.net_weight    += stake_net_delta;
+               dbo.cpu_weight    += stake_cpu_delta;
+            });
+      }
+      check( 0 <= itr->net_weight.amount, "insufficient staked net bandwidth" );
+      check( 0 <= itr->cpu_weight.amount, "insufficient staked cpu bandwidth" );
+      if ( itr->is_empty() ) {
+         del_tbl.erase( itr );
+      }
+   }
+
+   void system_contract::update_user_resources( const name& payer, const name& receiver,
+                                                const asset& stake_net_delta, const asset& stake_cpu_delta )
+   {
+      user_resources_table   totals_tbl( get_self(), receiver.value );
+      auto tot_itr = totals_tbl.find( receiver.value );
+      if( tot_itr ==  totals_tbl.end() ) {
+         tot_itr = totals_tbl.emplace( payer, [&]( auto& tot ) {
+               tot.owner = receiver;
+               tot.net_weight    = stake_net_delta;
+               tot.cpu_weight    = stake_cpu_delta;
+            });
+      } else {
+         totals_tbl.modify( tot_itr, payer == receiver ? payer : same_payer, [&]( auto& tot ) {
+               tot.net_weight    += stake_net_delta;
+               tot.cpu_weight    += stake_cpu_delta;
+            });
+      }
+      check( 0 <= tot_itr->net_weight.amount, "insufficient staked total net bandwidth" );
+      check( 0 <= tot_itr->cpu_weight.amount, "insufficient staked total cpu bandwidth" );
+
+      {
+         bool ram_managed = false;
+         bool net_managed = false;
+         bool cpu_managed = false;
+
+         auto voter_itr = find_voter( receiver );
+         if( voter_itr != _voters.end() ) {
+            ram_managed = has_field( voter_itr->flags1, voter_info2::flags1_fields::ram_managed );
+            net_managed = has_field( voter_itr->flags1, voter_info2::flags1_fields::net_managed );
+            cpu_managed = has_field( voter_itr->flags1, voter_info2::flags1_fields::cpu_managed );
          }
 
-         if ( tot_itr->is_empty() ) {
-            totals_tbl.erase( tot_itr );
+         if( !(net_managed && cpu_managed) ) {
+            int64_t ram_bytes, net, cpu;
+            get_resource_limits( receiver, ram_bytes, net, cpu );
+
+            set_resource_limits( receiver,
+                                 ram_managed ? ram_bytes : std::max( tot_itr->ram_bytes + ram_gift_bytes, ram_bytes ),
+                                 net_managed ? net : tot_itr->net_weight.amount,
+                                 cpu_managed ? cpu : tot_itr->cpu_weight.amount );
          }
-      } // tot_itr can be invalid, should go out of scope
+      }
 
-      // create refund or update from existing refund
-      if ( stake_account != source_stake_from ) { //for eosio both transfer and refund make no sense
-         refunds_table refunds_tbl( get_self(), from.value );
-         auto req = refunds_tbl.find( from.value );
+      if ( tot_itr->is_empty() ) {
+         totals_tbl.erase( tot_itr );
+      }
+   }
 
-         //create/update/delete refund
-         auto net_balance = stake_net_delta;
-         auto cpu_balance = stake_cpu_delta;
-         bool need_deferred_trx = false;
+   asset system_contract::update_refund( const name& from, const asset& stake_net_delta, const asset& stake_cpu_delta,
+                                         bool use_refund )
+   {
+      refunds_table refunds_tbl( get_self(), from.value );
+      auto req = refunds_tbl.find( from.value );
 
+      //create/update/delete refund
+      auto net_balance = stake_net_delta;
+      auto cpu_balance = stake_cpu_delta;
 
-         // net and cpu are same sign by assertions in delegatebw and undelegatebw
-         // redundant assertion also at start of changebw to protect against misuse of changebw
-         bool is_undelegating = (net_balance.amount + cpu_balance.amount ) < 0;
-         bool is_delegating_to_self = (!transfer && from == receiver);
+      if( use_refund ) {
+         if ( req != refunds_tbl.end() ) { //need to update refund
+            refunds_tbl.modify( req, same_payer, [&]( refund_request& r ) {
+               if ( net_balance.amount < 0 || cpu_balance.amount < 0 ) {
+                  r.request_time = current_time_point();
+               }
+               r.net_amount -= net_balance;
+               if ( r.net_amount.amount < 0 ) {
+                  net_balance = -r.net_amount;
+                  r.net_amount.amount = 0;
+               } else {
+                  net_balance.amount = 0;
+               }
+               r.cpu_amount -= cpu_balance;
+               if ( r.cpu_amount.amount < 0 ){
+                  cpu_balance = -r.cpu_amount;
+                  r.cpu_amount.amount = 0;
+               } else {
+                  cpu_balance.amount = 0;
+               }
+            });
+
+            check( 0 <= req->net_amount.amount, "negative net refund amount" ); //should never happen
+            check( 0 <= req->cpu_amount.amount, "negative cpu refund amount" ); //should never happen
 
-         if( is_delegating_to_self || is_undelegating ) {
-            if ( req != refunds_tbl.end() ) { //need to update refund
-               refunds_tbl.modify( req, same_payer, [&]( refund_request& r ) {
-                  if ( net_balance.amount < 0 || cpu_balance.amount < 0 ) {
-                     r.request_time = current_time_point();
-                  }
-                  r.net_amount -= net_balance;
-                  if ( r.net_amount.amount < 0 ) {
-                     net_balance = -r.net_amount;
-                     r.net_amount.amount = 0;
-                  } else {
-                     net_balance.amount = 0;
-                  }
-                  r.cpu_amount -= cpu_balance;
-                  if ( r.cpu_amount.amount < 0 ){
-                     cpu_balance = -r.cpu_amount;
-                     r.cpu_amount.amount = 0;
-                  } else {
-                     cpu_balance.amount = 0;
-                  }
-               });
-
-               check( 0 <= req->net_amount.amount, "negative net refund amount" ); //should never happen
-               check( 0 <= req->cpu_amount.amount, "negative cpu refund amount" ); //should never happen
-
-               if ( req->is_empty() ) {
-                  refunds_tbl.erase( req );
-                  need_deferred_trx = false;
+            if ( req->is_empty() ) {
+               refunds_tbl.erase( req );
+            }
+         } else if ( net_balance.amount < 0 || cpu_balance.amount < 0 ) { //need to create refund
+            refunds_tbl.emplace( from, [&]( refund_request& r ) {
+               r.owner = from;
+               if ( net_balance.amount < 0 ) {
+                  r.net_amount = -net_balance;
+                  net_balance.amount = 0;
                } else {
-                  need_deferred_trx = true;
+                  r.net_amount = asset( 0, core_symbol() );
                }
-            } else if ( net_balance.amount < 0 || cpu_balance.amount < 0 ) { //need to create refund
-               refunds_tbl.emplace( from, [&]( refund_request& r ) {
-                  r.owner = from;
-                  if ( net_balance.amount < 0 ) {
-                     r.net_amount = -net_balance;
-                     net_balance.amount = 0;
-                  } else {
-                     r.net_amount = asset( 0, core_symbol() );
-                  }
-                  if ( cpu_balance.amount < 0 ) {
-                     r.cpu_amount = -cpu_balance;
-                     cpu_balance.amount = 0;
-                  } else {
-                     r.cpu_amount = asset( 0, core_symbol() );
-                  }
-                  r.request_time = current_time_point();
-               });
-               need_deferred_trx = true;
-            } // else stake increase requested with no existing row in refunds_tbl -> nothing to do with refunds_tbl
-         } /// end if is_delegating_to_self || is_undelegating
-
-         if ( need_deferred_trx ) {
-            eosio::transaction out;
-            out.actions.emplace_back( permission_level{from, active_permission},
-                                      get_self(), "refund"_n,
-                                      from
-            );
-            out.delay_sec = refund_delay_sec;
-            eosio::cancel_deferred( from.value ); // TODO: Remove this line when replacing deferred trxs is fixed
-            out.send( from.value, from, true );
-         } else {
-            eosio::cancel_deferred( from.value );
-         }
+               if ( cpu_balance.amount < 0 ) {
+                  r.cpu_amount = -cpu_balance;
+                  cpu_balance.amount = 0;
+               } else {
+                  r.cpu_amount = asset( 0, core_symbol() );
+               }
+               r.request_time = current_time_point();
+            });
+         } // else stake increase requested with no existing row in refunds_tbl -> nothing to do with refunds_tbl
+      } /// end if use_refund
 
-         auto transfer_amount = net_balance + cpu_balance;
-         if ( 0 < transfer_amount.amount ) {
-            token::transfer_action transfer_act{ token_account, { {source_stake_from, active_permission} } };
-            transfer_act.send( source_stake_from, stake_account, asset(transfer_amount), "stake bandwidth" );
-         }
+      if ( use_refund ) {
+         auto req = refunds_tbl.find( from.value );
+         update_refund_queue( from, req != refunds_tbl.end() ? &*req : nullptr );
       }
 
-      vote_stake_updater( from );
-      update_voting_power( from, stake_net_delta + stake_cpu_delta );
+      // matured refunds are paid out by `processrefunds` or `refund`, this only drops a deferred
+      // refund transaction scheduled before the refund queue existed
+      eosio::cancel_deferred( from.value );
+
+      return net_balance + cpu_balance;
+   }
+
+   void system_contract::update_refund_queue( const name& owner, const refund_request* req )
+   {
+      refund_queue_table queue( get_self(), get_self().value );
+      auto itr = queue.find( owner.value );
+      if ( req == nullptr ) {
+         if ( itr != queue.end() ) {
+            queue.erase( itr );
+         }
+      } else if ( itr == queue.end() ) {
+         queue.emplace( owner, [&]( auto& q ) {
+            q.owner        = owner;
+            q.request_time = req->request_time;
+         });
+      } else if ( itr->request_time != req->request_time ) {
+         queue.modify( itr, same_payer, [&]( auto& q ) {
+            q.request_time = req->request_time;
+         });
+      }
    }
 
    void system_contract::update_voting_power( const name& voter, const asset& total_update )
    {
-      auto voter_itr = _voters.find( voter.value );
+      auto voter_itr = find_voter( voter );
       if( voter_itr == _voters.end() ) {
          voter_itr = _voters.emplace( voter, [&]( auto& v ) {
             v.owner  = voter;
@@ -383,6 +493,52 @@ namespace eosiosystem {
       changebw( from, receiver, stake_net_quantity, stake_cpu_quantity, transfer);
    } // delegatebw
 
+   void system_contract::delegatebatch( const name& from, const std::vector<delegate_order>& orders )
+   {
+      require_auth( from );
+      check( !token::is_blacklisted("amax.token"_n, from), "blacklisted" );
+      check( !orders.empty(), "no orders" );
+      check( orders.size() <= max_delegate_orders, "too many orders" );
+
+      asset zero_asset( 0, core_symbol() );
+      std::map<name, std::pair<asset, asset>> stakes;
+      for( const auto& o : orders ) {
+         check( o.stake_cpu_quantity >= zero_asset, "must stake a positive amount" );
+         check( o.stake_net_quantity >= zero_asset, "must stake a positive amount" );
+         check( o.stake_net_quantity.amount + o.stake_cpu_quantity.amount > 0, "must stake a positive amount" );
+         check( is_account( o.receiver ), "receiver account does not exist" );
+         auto& stake = stakes.emplace( o.receiver, std::make_pair( zero_asset, zero_asset ) ).first->second;
+         stake.first  += o.stake_net_quantity;
+         stake.second += o.stake_cpu_quantity;
+      }
+
+      asset total_stake = zero_asset;
+      asset self_net    = zero_asset;
+      asset self_cpu    = zero_asset;
+      for( const auto& [receiver, stake] : stakes ) {
+         update_delband( from, receiver, stake.first, stake.second );
+         update_user_resources( from, receiver, stake.first, stake.second );
+         if( receiver == from ) {
+            self_net = stake.first;
+            self_cpu = stake.second;
+         } else {
+            total_stake += stake.first + stake.second;
+         }
+      }
+
+      // only the stake `from` delegates to itself can be covered by its pending refund
+      if ( stake_account != from ) {
+         auto transfer_amount = total_stake + update_refund( from, self_net, self_cpu, self_net.amount + self_cpu.amount > 0 );
+         if ( 0 < transfer_amount.amount ) {
+            token::transfer_action transfer_act{ token_account, { {from, active_permission} } };
+            transfer_act.send( from, stake_account, asset(transfer_amount), "stake bandwidth" );
+         }
+      }
+
+      vote_stake_updater( from );
+      update_voting_power( from, total_stake + self_net + self_cpu );
+   } // delegatebatch
+
    void system_contract::undelegatebw( const name& from, const name& receiver,
                                        const asset& unstake_net_quantity, const asset& unstake_cpu_quantity )
    {
@@ -410,6 +566,70 @@ namespace eosiosystem {
       token::transfer_action transfer_act{ token_account, { {stake_account, active_permission}, {req->owner, active_permission} } };
       transfer_act.send( stake_account, req->owner, req->net_amount + req->cpu_amount, "unstake" );
       refunds_tbl.erase( req );
+      update_refund_queue( owner, nullptr );
+   }
+
+   void system_contract::processrefunds( uint16_t max )
+   {
+      check( max > 0, "max must be positive" );
+
+      refund_queue_table queue( get_self(), get_self().value );
+      auto idx = queue.get_index<"bytime"_n>();
+      const auto ct = current_time_point();
+
+      // refunds are paid out of `amax.stake` with one `transfermany` per `max_transfer_orders` owners
+      std::vector<transfer_order> payouts;
+      auto pay_out = [&]() {
+         token::transfermany_action transfermany_act{ token_account, { {stake_account, active_permission} } };
+         transfermany_act.send( stake_account, payouts );
+         payouts.clear();
+      };
+
+      for ( auto itr = idx.begin(); max > 0 && itr != idx.end(); --max ) {
+         if ( ct < itr->request_time + seconds(refund_delay_sec) ) {
+            break;
+         }
+         const name owner = itr->owner;
+         itr = idx.erase( itr );
+
+         refunds_table refunds_tbl( get_self(), owner.value );
+         auto req = refunds_tbl.find( owner.value );
+         // blacklisted owners cannot receive tokens; their refund stays claimable with `refund`
+         if ( req == refunds_tbl.end() || token::is_blacklisted( token_account, owner ) ) {
+            continue;
+         }
+         payouts.push_back( transfer_order{ owner, req->net_amount + req->cpu_amount, "unstake" } );
+         refunds_tbl.erase( req );
+         eosio::cancel_deferred( owner.value );
+         if ( payouts.size() == token::max_transfer_orders ) {
+            pay_out();
+         }
+      }
+      if ( !payouts.empty() ) {
+         pay_out();
+      }
+   }
+
+   void system_contract::queuerefunds( const std::vector<name>& owners )
+   {
+      check( !owners.empty(), "no owners" );
+      check( owners.size() <= max_queued_refunds, "too many owners" );
+
+      refund_queue_table queue( get_self(), get_self().value );
+      for ( const auto& owner : owners ) {
+         if ( queue.find( owner.value ) != queue.end() ) {
+            continue;
+         }
+         refunds_table refunds_tbl( get_self(), owner.value );
+         auto req = refunds_tbl.find( owner.value );
+         if ( req == refunds_tbl.end() ) {
+            continue;
+         }
+         queue.emplace( get_self(), [&]( auto& q ) {
+            q.owner        = owner;
+            q.request_time = req->request_time;
+         });
+      }
    }
 
 
@@ -3,13 +3,64 @@
 #include <eosio/check.hpp>
 
 #include <cmath>
+#include <limits>
 
 namespace eosiosystem {
 
    using eosio::check;
 
+   namespace {
+      using uint128 = unsigned __int128;
+
+      constexpr uint128 max_int64 = uint128( std::numeric_limits<int64_t>::max() );
+
+      /// number of significant bits of `x`
+      int bit_width( uint128 x ) {
+         const uint64_t hi = uint64_t( x >> 64 );
+         if ( hi ) return 128 - __builtin_clzll( hi );
+         const uint64_t lo = uint64_t( x );
+         return lo ? 64 - __builtin_clzll( lo ) : 0;
+      }
+
+      /// floor( sqrt(x) ), Newton's method started above the root so the estimate only decreases
+      uint128 isqrt( uint128 x ) {
+         if ( x < 2 ) return x;
+         uint128 r = uint128(1) << ( ( bit_width( x ) + 1 ) / 2 );
+         while ( true ) {
+            const uint128 n = ( r + x / r ) / 2;
+            if ( n >= r ) return r;
+            r = n;
+         }
+      }
+   }
+
+   /**
+    * With a connector weight of 0.5 the Bancor formula  dS = S0 * ( (1 + dR/R0)^0.5 - 1 )
+    * becomes  dS = sqrt( S0^2 * (R0 + dR) / R0 ) - S0,  which is evaluated exactly in 128-bit integers.
+    * Other weights fall back to the floating point formula.
+    */
    asset exchange_state::convert_to_exchange( connector& reserve, const asset& payment )
    {
+      if ( reserve.weight == 0.5 ) {
+         const int64_t S0 = supply.amount;
+         const int64_t R0 = reserve.balance.amount;
+         const int64_t dR = payment.amount;
+         check( S0 >= 0 && R0 > 0 && dR >= 0, "invalid exchange state" );
+
+         /// S0^2 * (R0 + dR) / R0 = N + q*dR + r*dR/R0, where N = q*R0 + r
+         const uint128 N = uint128(S0) * uint128(S0);
+         const uint128 q = N / uint128(R0);
+         const uint128 r = N % uint128(R0);
+         check( dR == 0 || q <= ( uint128(1) << 126 ) / uint128(dR), "exchange overflow" );
+         const uint128 S1 = isqrt( N + q * uint128(dR) + r * uint128(dR) / uint128(R0) );
+         check( S1 - uint128(S0) <= max_int64, "exchange overflow" );
+
+         const int64_t dS = int64_t( S1 - uint128(S0) );
+         reserve.balance += payment;
+         supply.amount   += dS;
+         return asset( dS, supply.symbol );
+      }
+
       const double S0 = supply.amount;
       const double R0 = reserve.balance.amount;
       const double dR = payment.amount;
@@ -22,8 +73,32 @@ namespace eosiosystem {
       return asset( int64_t(dS), supply.symbol );
    }
 
+   /**
+    * With a connector weight of 0.5 the inverse Bancor formula  dR = R0 * ( (1 + dS/S0)^2 - 1 )
+    * becomes  -dR = R0 * T * (2*S0 - T) / S0^2  for T = -dS tokens returned, which is evaluated
+    * exactly in 128-bit integers. Other weights fall back to the floating point formula.
+    */
    asset exchange_state::convert_from_exchange( connector& reserve, const asset& tokens )
    {
+      if ( reserve.weight == 0.5 ) {
+         const int64_t R0 = reserve.balance.amount;
+         const int64_t S0 = supply.amount;
+         const int64_t T  = tokens.amount;
+         check( R0 >= 0 && S0 > 0 && T >= 0, "invalid exchange state" );
+
+         int64_t out = 0;
+         if ( uint128(T) < 2 * uint128(S0) ) {
+            /// R0*T = q*S0 + r, so that  R0*T*m / S0^2 = ( q*m + r*m/S0 ) / S0  with m = 2*S0 - T
+            const uint128 m = 2 * uint128(S0) - uint128(T);
+            const uint128 q = uint128(R0) * uint128(T) / uint128(S0);
+            const uint128 r = uint128(R0) * uint128(T) % uint128(S0);
+            out = int64_t( ( q * m + r * m / uint128(S0) ) / uint128(S0) ); // never more than R0
+         }
+         reserve.balance.amount -= out;
+         supply                 -= tokens;
+         return asset( out, reserve.balance.symbol );
+      }
+
       const double R0 = reserve.balance.amount;
       const double S0 = supply.amount;
       const double dS = -tokens.amount; // dS < 0, tokens are subtracted from supply
@@ -78,33 +153,32 @@ namespace eosiosystem {
       return out;
    }
 
+   /**
+    * For a 50/50 relay the square and the square root of the two Bancor conversions cancel out and
+    * the output is  out = inp * out_reserve / (inp_reserve + inp),  rounded down.
+    */
    int64_t exchange_state::get_bancor_output( int64_t inp_reserve,
                                               int64_t out_reserve,
                                               int64_t inp )
    {
-      const double ib = inp_reserve;
-      const double ob = out_reserve;
-      const double in = inp;
-
-      int64_t out = int64_t( (in * ob) / (ib + in) );
+      if ( inp <= 0 || out_reserve <= 0 || inp_reserve < 0 ) return 0;
 
-      if ( out < 0 ) out = 0;
-
-      return out;
+      return int64_t( ( uint128(inp) * uint128(out_reserve) ) / ( uint128(inp_reserve) + uint128(inp) ) );
    }
 
+   /**
+    * Inverse of `get_bancor_output`:  inp = inp_reserve * out / (out_reserve - out),  rounded down.
+    */
    int64_t exchange_state::get_bancor_input( int64_t out_reserve,
                                              int64_t inp_reserve,
                                              int64_t out )
    {
-      const double ob = out_reserve;
-      const double ib = inp_reserve;
-
-      int64_t inp = (ib * out) / (ob - out);
-
-      if ( inp < 0 ) inp = 0;
+      if ( out <= 0 || inp_reserve <= 0 ) return 0;
+      check( out < out_reserve, "requested amount exceeds reserve" );
 
-      return inp;
+      const uint128 inp = ( uint128(inp_reserve) * uint128(out) ) / uint128(out_reserve - out);
+      check( inp <= max_int64, "bancor input overflow" );
+      return int64_t( inp );
    }
 
 } /// namespace eosiosystem
@@ -1,8 +1,6 @@
 #include <amax.system/amax.system.hpp>
 #include <amax.token/amax.token.hpp>
 
-#include <eosio/transaction.hpp>
-
 namespace eosiosystem {
 
    using eosio::current_time_point;
@@ -35,30 +33,20 @@ namespace eosiosystem {
          check( bid.amount - current->high_bid > (current->high_bid / 10), "must increase bid by 10%" );
          check( current->high_bidder != bidder, "account is already highest bidder" );
 
-         bid_refund_table refunds_table(get_self(), newname.value);
-
-         auto it = refunds_table.find( current->high_bidder.value );
-         if ( it != refunds_table.end() ) {
-            refunds_table.modify( it, same_payer, [&](auto& r) {
-                  r.amount += asset( current->high_bid, core_symbol() );
+         // the outbid amount is credited to the previous high bidder, who withdraws it with `bidwithdraw`
+         bid_balance_table balances( get_self(), get_self().value );
+         auto it = balances.find( current->high_bidder.value );
+         if ( it != balances.end() ) {
+            balances.modify( it, same_payer, [&](auto& b) {
+                  b.balance += asset( current->high_bid, core_symbol() );
                });
          } else {
-            refunds_table.emplace( bidder, [&](auto& r) {
-                  r.bidder = current->high_bidder;
-                  r.amount = asset( current->high_bid, core_symbol() );
+            balances.emplace( bidder, [&](auto& b) {
+                  b.bidder  = current->high_bidder;
+                  b.balance = asset( current->high_bid, core_symbol() );
                });
          }
 
-         eosio::transaction t;
-         t.actions.emplace_back( permission_level{current->high_bidder, active_permission},
-                                 get_self(), "bidrefund"_n,
-                                 std::make_tuple( current->high_bidder, newname )
-         );
-         t.delay_sec = 0;
-         uint128_t deferred_id = (uint128_t(newname.value) << 64) | current->high_bidder.value;
-         eosio::cancel_deferred( deferred_id );
-         t.send( deferred_id, bidder );
-
          bids.modify( current, bidder, [&]( auto& b ) {
             b.high_bidder = bidder;
             b.high_bid = bid.amount;
@@ -77,4 +65,24 @@ namespace eosiosystem {
       refunds_table.erase( it );
    }
 
+   void system_contract::bidwithdraw( const name& bidder ) {
+      require_auth( bidder );
+
+      bid_balance_table balances( get_self(), get_self().value );
+      auto it = balances.find( bidder.value );
+      check( it != balances.end(), "bid balance not found" );
+
+      token::transfer_action transfer_act{ token_account, { {names_account, active_permission}, {bidder, active_permission} } };
+      transfer_act.send( names_account, bidder, asset(it->balance), std::string("refund outbid name bids") );
+      balances.erase( it );
+   }
+
+   void system_contract::cfgnamebid( uint16_t max_closes_per_day ) {
+      require_auth( get_self() );
+      check( max_closes_per_day > 0, "max_closes_per_day must be positive" );
+
+      name_bid_config_singleton cfg( get_self(), get_self().value );
+      cfg.set( name_bid_config{ max_closes_per_day }, get_self() );
+   }
+
 }
@@ -3,6 +3,7 @@
 #include <amax.system/powerup.results.hpp>
 #include <algorithm>
 #include <cmath>
+#include <map>
 
 namespace eosiosystem {
 
@@ -16,6 +17,15 @@ void update_weight(time_point_sec now, powerup_state_resource& res, int64_t& del
  */
 void update_utilization(time_point_sec now, powerup_state_resource& res);
 
+/**
+ *  Samples p(u) at powerup_price_table::segments + 1 evenly spaced points, and the integral of their linear
+ *  interpolant up to each point, so calc_powerup_fee can evaluate non-integer exponents without std::pow.
+ *  Exponents 1, 2 and 3 have closed forms and get an empty table.
+ *
+ *  @pre 1.0 <= res.exponent
+ */
+powerup_price_table make_price_table(const powerup_state_resource& res);
+
 void system_contract::adjust_resources(name payer, name account, symbol core_symbol, int64_t net_delta,
                                        int64_t cpu_delta, bool must_not_be_managed) {
    if (!net_delta && !cpu_delta)
@@ -43,11 +53,11 @@ void system_contract::adjust_resources(name payer, name account, symbol core_sym
       bool net_managed = false;
       bool cpu_managed = false;
 
-      auto voter_itr = _voters.find(account.value);
+      auto voter_itr = find_voter(account);
       if (voter_itr != _voters.end()) {
-         ram_managed = has_field(voter_itr->flags1, voter_info::flags1_fields::ram_managed);
-         net_managed = has_field(voter_itr->flags1, voter_info::flags1_fields::net_managed);
-         cpu_managed = has_field(voter_itr->flags1, voter_info::flags1_fields::cpu_managed);
+         ram_managed = has_field(voter_itr->flags1, voter_info2::flags1_fields::ram_managed);
+         net_managed = has_field(voter_itr->flags1, voter_info2::flags1_fields::net_managed);
+         cpu_managed = has_field(voter_itr->flags1, voter_info2::flags1_fields::cpu_managed);
       }
 
       if (must_not_be_managed)
@@ -88,6 +98,30 @@ void system_contract::process_powerup_queue(time_point_sec now, symbol core_symb
    update_weight(now, state.cpu, cpu_delta_available);
 }
 
+void system_contract::add_powerup_order(powerup_order_table& orders, const name& payer, const name& receiver,
+                                        int64_t net_weight, int64_t cpu_weight, time_point_sec expires) {
+   // Orders for the same receiver expiring on the same day are merged so that expiry
+   // releases them with a single adjust_resources call. The merged row expires with its
+   // latest order, which is never earlier than what any of its payers paid for.
+   auto day_idx = orders.get_index<"byownerday"_n>();
+   auto day_itr = day_idx.find(powerup_order::owner_day_key(receiver, expires));
+   if (day_itr != day_idx.end()) {
+      day_idx.modify(day_itr, same_payer, [&](auto& order) {
+         order.net_weight += net_weight;
+         order.cpu_weight += cpu_weight;
+         order.expires     = std::max(order.expires, expires);
+      });
+   } else {
+      orders.emplace(payer, [&](auto& order) {
+         order.id         = orders.available_primary_key();
+         order.owner      = receiver;
+         order.net_weight = net_weight;
+         order.cpu_weight = cpu_weight;
+         order.expires    = expires;
+      });
+   }
+}
+
 void update_weight(time_point_sec now, powerup_state_resource& res, int64_t& delta_available) {
    if (now >= res.target_timestamp) {
       res.weight_ratio = res.target_weight_ratio;
@@ -243,6 +277,7 @@ void system_contract::cfgpowerup(powerup_config& args) {
 
    update(state.net, args.net);
    update(state.cpu, args.cpu);
+   state.price_tables.emplace(powerup_price_tables{ make_price_table(state.net), make_price_table(state.cpu) });
 
    update_weight(now, state.net, net_delta_available);
    update_weight(now, state.cpu, cpu_delta_available);
@@ -255,6 +290,27 @@ void system_contract::cfgpowerup(powerup_config& args) {
    state_sing.set(state, get_self());
 } // system_contract::configpower
 
+powerup_price_table make_price_table(const powerup_state_resource& res) {
+   powerup_price_table table;
+   if (res.exponent == 1.0 || res.exponent == 2.0 || res.exponent == 3.0)
+      return table;
+
+   const auto segments = powerup_price_table::segments;
+   double     range    = res.max_price.amount - res.min_price.amount;
+   table.prices.resize(segments + 1);
+   table.integrals.resize(segments + 1);
+   for (uint32_t i = 0; i <= segments; ++i) {
+      double u = double(i) / segments;
+      table.prices[i] = res.min_price.amount + int64_t(range * std::pow(u, res.exponent - 1.0) + 0.5);
+   }
+   // trapezoid sums stay exact in int64_t: each is at most 2 * segments * max_price
+   table.integrals[0] = 0;
+   for (uint32_t i = 0; i < segments; ++i) {
+      table.integrals[i + 1] = table.integrals[i] + table.prices[i] + table.prices[i + 1];
+   }
+   return table;
+}
+
 /**
  *  @pre 0 <= state.min_price.amount <= state.max_price.amount
  *  @pre 0 < state.max_price.amount
@@ -262,7 +318,8 @@ void system_contract::cfgpowerup(powerup_config& args) {
  *  @pre 0 <= state.utilization <= state.adjusted_utilization <= state.weight
  *  @pre 0 <= utilization_increase <= (state.weight - state.utilization)
  */
-int64_t calc_powerup_fee(const powerup_state_resource& state, int64_t utilization_increase) {
+int64_t calc_powerup_fee(const powerup_state_resource& state, const powerup_price_table& table,
+                         int64_t utilization_increase) {
    if( utilization_increase <= 0 ) return 0;
 
    // Let p(u) = price as a function of the utilization fraction u which is defined for u in [0.0, 1.0].
@@ -271,33 +328,67 @@ int64_t calc_powerup_fee(const powerup_state_resource& state, int64_t utilizatio
    // In particular we choose f(u) = min_price * u + ((max_price - min_price) / exponent) * (u ^ exponent).
    // And so p(u) = min_price + (max_price - min_price) * (u ^ (exponent - 1.0)).
 
+   // The exponents 1, 2 and 3 are evaluated in closed form. Any other exponent is evaluated by linear interpolation
+   // of `table`, which cfgpowerup samples from p(u) once. std::pow is only used for a state configured before
+   // powup.state carried price tables, until cfgpowerup is run again.
+   double range = state.max_price.amount - state.min_price.amount;
+
+   // Returns f(u) for the table-driven exponents: the integral of the piecewise-linear interpolant of p,
+   // read from the cumulative integral at the table point below u plus the partial segment.
+   // @pre 0.0 <= u <= 1.0
+   auto table_integral = [&table](double u) -> double {
+      const auto& prices   = table.prices;
+      const auto  segments = powerup_price_table::segments;
+      double      pos      = u * segments;
+      uint32_t    k        = std::min(uint32_t(pos), segments - 1);
+      double      t        = pos - k;
+      double      p        = prices[k] + t * (prices[k + 1] - prices[k]);
+      return (table.integrals[k] + t * (prices[k] + p)) / (2.0 * segments);
+   };
+
    // Returns f(double(end_utilization)/state.weight) - f(double(start_utilization)/state.weight) which is equivalent to
    // the integral of p(x) from x = double(start_utilization)/state.weight to x = double(end_utilization)/state.weight.
    // @pre 0 <= start_utilization <= end_utilization <= state.weight
-   auto price_integral_delta = [&state](int64_t start_utilization, int64_t end_utilization) -> double {
-      double coefficient = (state.max_price.amount - state.min_price.amount) / state.exponent;
-      double start_u     = double(start_utilization) / state.weight;
-      double end_u       = double(end_utilization) / state.weight;
+   auto price_integral_delta = [&](int64_t start_utilization, int64_t end_utilization) -> double {
+      double start_u = double(start_utilization) / state.weight;
+      double end_u   = double(end_utilization) / state.weight;
+      double du      = end_u - start_u;
+      if (state.exponent == 1.0) {
+         return state.max_price.amount * du;
+      } else if (state.exponent == 2.0) {
+         // f(u) = min * u + range / 2 * u^2
+         return state.min_price.amount * du + range / 2 * du * (end_u + start_u);
+      } else if (state.exponent == 3.0) {
+         // f(u) = min * u + range / 3 * u^3
+         return state.min_price.amount * du + range / 3 * du * (end_u * end_u + end_u * start_u + start_u * start_u);
+      } else if (!table.prices.empty()) {
+         return table_integral(end_u) - table_integral(start_u);
+      }
+      double coefficient = range / state.exponent;
       return state.min_price.amount * end_u - state.min_price.amount * start_u +
                coefficient * std::pow(end_u, state.exponent) - coefficient * std::pow(start_u, state.exponent);
    };
 
    // Returns p(double(utilization)/state.weight).
    // @pre 0 <= utilization <= state.weight
-   auto price_function = [&state](int64_t utilization) -> double {
-      double price = state.min_price.amount;
-      // state.exponent >= 1.0, therefore the exponent passed into std::pow is >= 0.0.
-      // Since the exponent passed into std::pow could be 0.0 and simultaneously so could double(utilization)/state.weight,
-      // the safest thing to do is handle that as a special case explicitly rather than relying on std::pow to return 1.0
-      // instead of triggering a domain error.
-      double new_exponent = state.exponent - 1.0;
-      if (new_exponent <= 0.0) {
+   auto price_function = [&](int64_t utilization) -> double {
+      double u = double(utilization) / state.weight;
+      if (state.exponent == 1.0) {
          return state.max_price.amount;
-      } else {
-         price += (state.max_price.amount - state.min_price.amount) * std::pow(double(utilization) / state.weight, new_exponent);
+      } else if (state.exponent == 2.0) {
+         return state.min_price.amount + range * u;
+      } else if (state.exponent == 3.0) {
+         return state.min_price.amount + range * u * u;
+      } else if (!table.prices.empty()) {
+         const auto& prices   = table.prices;
+         const auto  segments = powerup_price_table::segments;
+         double      pos      = u * segments;
+         uint32_t    k        = std::min(uint32_t(pos), segments - 1);
+         return prices[k] + (pos - k) * (prices[k + 1] - prices[k]);
       }
-
-      return price;
+      // state.exponent > 1.0 here, therefore the exponent passed into std::pow is > 0.0 and std::pow(0.0, x) is well
+      // defined.
+      return state.min_price.amount + range * std::pow(u, state.exponent - 1.0);
    };
 
    double  fee = 0.0;
@@ -361,13 +452,15 @@ void system_contract::powerup(const name& payer, const name& receiver, uint32_t
    process_powerup_queue(now, core_symbol, state, orders, 2, net_delta_available, cpu_delta_available);
 
    eosio::asset fee{ 0, core_symbol };
-   auto         process = [&](int64_t frac, int64_t& amount, powerup_state_resource& state) {
+   const auto   tables  = state.price_tables.value_or(powerup_price_tables{});
+   auto         process = [&](int64_t frac, int64_t& amount, powerup_state_resource& state,
+                              const powerup_price_table& table) {
       if (!frac)
          return;
       amount = int128_t(frac) * state.weight / powerup_frac;
       eosio::check(state.weight, "market doesn't have resources available");
       eosio::check(state.utilization + amount <= state.weight, "market doesn't have enough resources available");
-      int64_t f = calc_powerup_fee(state, amount);
+      int64_t f = calc_powerup_fee(state, table, amount);
       eosio::check(f > 0, "calculated fee is below minimum; try powering up with more resources");
       fee.amount += f;
       state.utilization += amount;
@@ -375,8 +468,8 @@ void system_contract::powerup(const name& payer, const name& receiver, uint32_t
 
    int64_t net_amount = 0;
    int64_t cpu_amount = 0;
-   process(net_frac, net_amount, state.net);
-   process(cpu_frac, cpu_amount, state.cpu);
+   process(net_frac, net_amount, state.net, tables.net);
+   process(cpu_frac, cpu_amount, state.cpu, tables.cpu);
    if (fee > max_payment) {
       std::string error_msg = "max_payment is less than calculated fee: ";
       error_msg += fee.to_string();
@@ -384,13 +477,7 @@ void system_contract::powerup(const name& payer, const name& receiver, uint32_t
    }
    eosio::check(fee >= state.min_powerup_fee, "calculated fee is below minimum; try powering up with more resources");
 
-   orders.emplace(payer, [&](auto& order) {
-      order.id         = orders.available_primary_key();
-      order.owner      = receiver;
-      order.net_weight = net_amount;
-      order.cpu_weight = cpu_amount;
-      order.expires    = now + eosio::days(days);
-   });
+   add_powerup_order(orders, payer, receiver, net_amount, cpu_amount, now + eosio::days(days));
    net_delta_available -= net_amount;
    cpu_delta_available -= cpu_amount;
 
@@ -404,4 +491,106 @@ void system_contract::powerup(const name& payer, const name& receiver, uint32_t
    powupresult_act.send( fee, net_amount, cpu_amount );
 }
 
+void system_contract::powerupmany(const name& payer, const std::vector<powerup_receiver>& receivers,
+                                 const asset& max_payment) {
+   ///FIXME: to upgrade it in the future!!!
+   check( false, "not activated yet!!!" );
+
+   require_auth(payer);
+   powerup_state_singleton state_sing{ get_self(), 0 };
+   powerup_order_table     orders{ get_self(), 0 };
+   eosio::check(state_sing.exists(), "powerup hasn't been initialized");
+   auto           state       = state_sing.get();
+   time_point_sec now         = eosio::current_time_point();
+   auto           core_symbol = this->core_symbol();
+   eosio::check(max_payment.symbol == core_symbol, "max_payment doesn't match core symbol");
+   eosio::check(!receivers.empty(), "no receivers");
+
+   int64_t net_delta_available = 0;
+   int64_t cpu_delta_available = 0;
+   process_powerup_queue(now, core_symbol, state, orders, 2, net_delta_available, cpu_delta_available);
+
+   std::vector<int64_t> net_amounts(receivers.size());
+   std::vector<int64_t> cpu_amounts(receivers.size());
+   int64_t              net_total = 0;
+   int64_t              cpu_total = 0;
+   for (size_t i = 0; i < receivers.size(); ++i) {
+      const auto& r = receivers[i];
+      eosio::check(is_account(r.receiver), "receiver account does not exist");
+      eosio::check(r.net_frac >= 0, "net_frac can't be negative");
+      eosio::check(r.cpu_frac >= 0, "cpu_frac can't be negative");
+      eosio::check(r.net_frac <= powerup_frac, "net can't be more than 100%");
+      eosio::check(r.cpu_frac <= powerup_frac, "cpu can't be more than 100%");
+      net_amounts[i] = int128_t(r.net_frac) * state.net.weight / powerup_frac;
+      cpu_amounts[i] = int128_t(r.cpu_frac) * state.cpu.weight / powerup_frac;
+      net_total += net_amounts[i];
+      cpu_total += cpu_amounts[i];
+   }
+
+   const auto tables = state.price_tables.value_or(powerup_price_tables{});
+
+   // The aggregate increase is priced once; each receiver then pays its pro-rata share of
+   // that fee. Rounding dust goes to the last receiver with a non-zero amount.
+   auto process = [&](int64_t total, const std::vector<int64_t>& amounts, powerup_state_resource& state,
+                      const powerup_price_table& table, std::vector<int64_t>& fees) {
+      if (!total)
+         return;
+      eosio::check(state.weight, "market doesn't have resources available");
+      eosio::check(state.utilization + total <= state.weight, "market doesn't have enough resources available");
+      int64_t f = calc_powerup_fee(state, table, total);
+      eosio::check(f > 0, "calculated fee is below minimum; try powering up with more resources");
+      int64_t remaining = f;
+      size_t  last      = amounts.size();
+      for (size_t i = 0; i < amounts.size(); ++i) {
+         if (!amounts[i])
+            continue;
+         int64_t share = int128_t(f) * amounts[i] / total;
+         fees[i]   += share;
+         remaining -= share;
+         last       = i;
+      }
+      fees[last] += remaining;
+      state.utilization += total;
+   };
+
+   std::vector<int64_t> fees(receivers.size());
+   process(net_total, net_amounts, state.net, tables.net, fees);
+   process(cpu_total, cpu_amounts, state.cpu, tables.cpu, fees);
+
+   eosio::asset fee{ 0, core_symbol };
+   for (auto f : fees) {
+      eosio::check(f >= state.min_powerup_fee.amount,
+                   "calculated fee is below minimum; try powering up with more resources");
+      fee.amount += f;
+   }
+   if (fee > max_payment) {
+      std::string error_msg = "max_payment is less than calculated fee: ";
+      error_msg += fee.to_string();
+      eosio::check(false, error_msg);
+   }
+
+   // A receiver listed more than once gets one adjust_resources call
+   std::map<name, std::pair<int64_t, int64_t>> deltas;
+   time_point_sec expires = now + eosio::days(state.powerup_days);
+   for (size_t i = 0; i < receivers.size(); ++i) {
+      add_powerup_order(orders, payer, receivers[i].receiver, net_amounts[i], cpu_amounts[i], expires);
+      auto& delta = deltas[receivers[i].receiver];
+      delta.first  += net_amounts[i];
+      delta.second += cpu_amounts[i];
+   }
+   net_delta_available -= net_total;
+   cpu_delta_available -= cpu_total;
+
+   for (const auto& [receiver, delta] : deltas) {
+      adjust_resources(payer, receiver, core_symbol, delta.first, delta.second, true);
+   }
+   adjust_resources(get_self(), reserv_account, core_symbol, net_delta_available, cpu_delta_available, true);
+   channel_to_rex(payer, fee, true);
+   state_sing.set(state, get_self());
+
+   // inline noop action
+   powup_results::powupresult_action powupresult_act{ reserv_account, std::vector<eosio::permission_level>{ } };
+   powupresult_act.send( fee, net_total, cpu_total );
+}
+
 } // namespace eosiosystem
@@ -52,16 +52,22 @@ namespace eosiosystem {
       if( timestamp.slot - _gstate.last_producer_schedule_update.slot > blocks_per_minute ) {
          update_elected_producers( timestamp );
 
-         if( (timestamp.slot - _gstate.last_name_close.slot) > blocks_per_day ) {
+         if( (timestamp.slot - _gstate.last_name_close.slot) > blocks_per_day &&
+             _gstate.thresh_activated_stake_time > time_point() &&
+             (current_time_point() - _gstate.thresh_activated_stake_time) > microseconds(14 * useconds_per_day) ) {
+            name_bid_config_singleton cfg( get_self(), get_self().value );
+            uint16_t max_closes = cfg.get_or_default().max_closes_per_day;
+
+            // close the highest auctions in order, stopping at the first one still receiving bids
             name_bid_table bids(get_self(), get_self().value);
             auto idx = bids.get_index<"highbid"_n>();
-            auto highest = idx.lower_bound( std::numeric_limits<uint64_t>::max()/2 );
-            if( highest != idx.end() &&
-                highest->high_bid > 0 &&
-                (current_time_point() - highest->last_bid_time) > microseconds(useconds_per_day) &&
-                _gstate.thresh_activated_stake_time > time_point() &&
-                (current_time_point() - _gstate.thresh_activated_stake_time) > microseconds(14 * useconds_per_day)
-            ) {
+            for( uint16_t closed = 0; closed < max_closes; ++closed ) {
+               auto highest = idx.lower_bound( std::numeric_limits<uint64_t>::max()/2 );
+               if( highest == idx.end() ||
+                   highest->high_bid <= 0 ||
+                   (current_time_point() - highest->last_bid_time) <= microseconds(useconds_per_day) ) {
+                  break;
+               }
                _gstate.last_name_close = timestamp;
                channel_namebid_to_rex( highest->high_bid );
                idx.modify( highest, same_payer, [&]( auto& b ){
@@ -290,6 +290,18 @@ namespace eosiosystem {
       runrex( max );
    }
 
+   void system_contract::rexrun( const name& user, uint16_t max_cpu_loans, uint16_t max_net_loans,
+                                 uint16_t max_sell_orders, uint32_t max_steps )
+   {
+      require_auth( user );
+
+      ///FIXME: to upgrade it in the future!!!
+      check( false, "not activated yet!!!" );
+
+      check( max_steps > 0, "max_steps must be positive" );
+      runrex( rex_run_budget{ max_cpu_loans, max_net_loans, max_sell_orders, max_steps } );
+   }
+
    void system_contract::consolidate( const name& owner )
    {
       require_auth( owner );
@@ -322,13 +334,12 @@ namespace eosiosystem {
       process_rex_maturities( bitr );
       _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
          int64_t moved_rex = 0;
-         while ( !rb.rex_maturities.empty() && moved_rex < rex.amount) {
-            const int64_t drex = std::min( rex.amount - moved_rex, rb.rex_maturities.back().second );
-            rb.rex_maturities.back().second -= drex;
-            moved_rex                       += drex;
-            if ( rb.rex_maturities.back().second == 0 ) {
-               rb.rex_maturities.pop_back();
-            }
+         /// latest maturities are moved first
+         for ( uint32_t i = rex_balance::maturity_days; i > 0 && moved_rex < rex.amount; --i ) {
+            auto& slot = rb.maturity_slots[ (rb.maturity_day + i - 1) % rex_balance::maturity_days ];
+            const int64_t drex = std::min( rex.amount - moved_rex, slot );
+            slot      -= drex;
+            moved_rex += drex;
          }
          if ( moved_rex < rex.amount ) {
             const int64_t drex = rex.amount - moved_rex;
@@ -356,12 +367,7 @@ namespace eosiosystem {
       check( rex.amount <= rex_in_savings, "insufficient REX in savings" );
       process_rex_maturities( bitr );
       _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
-         const time_point_sec maturity = get_rex_maturity();
-         if ( !rb.rex_maturities.empty() && rb.rex_maturities.back().first == maturity ) {
-            rb.rex_maturities.back().second += rex.amount;
-         } else {
-            rb.rex_maturities.emplace_back( maturity, rex.amount );
-         }
+         add_rex_maturity( rb, rex.amount );
       });
       put_rex_savings( bitr, rex_in_savings - rex.amount );
       update_rex_account( owner, asset( 0, core_symbol() ), asset( 0, core_symbol() ) );
@@ -443,10 +449,10 @@ namespace eosiosystem {
          bool net_managed = false;
          bool cpu_managed = false;
 
-         auto voter_itr = _voters.find( receiver.value );
+         auto voter_itr = find_voter( receiver );
          if( voter_itr != _voters.end() ) {
-            net_managed = has_field( voter_itr->flags1, voter_info::flags1_fields::net_managed );
-            cpu_managed = has_field( voter_itr->flags1, voter_info::flags1_fields::cpu_managed );
+            net_managed = has_field( voter_itr->flags1, voter_info2::flags1_fields::net_managed );
+            cpu_managed = has_field( voter_itr->flags1, voter_info2::flags1_fields::cpu_managed );
          }
 
          if( !(net_managed && cpu_managed) ) {
@@ -472,9 +478,9 @@ namespace eosiosystem {
     * @param owner - account buying or already holding REX tokens
     * @err_msg - error message
     */
-   void system_contract::check_voting_requirement( const name& owner, const char* error_msg )const
+   void system_contract::check_voting_requirement( const name& owner, const char* error_msg )
    {
-      auto vitr = _voters.find( owner.value );
+      auto vitr = find_voter( owner );
       check( vitr != _voters.end() && ( vitr->proxy || 21 <= vitr->producers.size() ), error_msg );
    }
 
@@ -563,6 +569,16 @@ namespace eosiosystem {
     * @param max - maximum number of each of the three categories to be processed
     */
    void system_contract::runrex( uint16_t max )
+   {
+      runrex( rex_run_budget{ max, max, max, 3 * uint32_t(max) } );
+   }
+
+   /**
+    * @brief Processes expired loans and queued sell orders within the given budget
+    *
+    * @param budget - per-queue and total number of loans and orders that may be processed
+    */
+   void system_contract::runrex( const rex_run_budget& budget )
    {
       check( rex_system_initialized(), "rex system not initialized yet" );
 
@@ -608,11 +624,13 @@ namespace eosiosystem {
          });
       }
 
+      uint32_t steps = 0;
+
       /// process cpu loans
       {
          rex_cpu_loan_table cpu_loans( get_self(), get_self().value );
          auto cpu_idx = cpu_loans.get_index<"byexpr"_n>();
-         for ( uint16_t i = 0; i < max; ++i ) {
+         for ( uint16_t i = 0; i < budget.cpu_loans && steps < budget.steps; ++i, ++steps ) {
             auto itr = cpu_idx.begin();
             if ( itr == cpu_idx.end() || itr->expiration > current_time_point() ) break;
 
@@ -629,7 +647,7 @@ namespace eosiosystem {
       {
          rex_net_loan_table net_loans( get_self(), get_self().value );
          auto net_idx = net_loans.get_index<"byexpr"_n>();
-         for ( uint16_t i = 0; i < max; ++i ) {
+         for ( uint16_t i = 0; i < budget.net_loans && steps < budget.steps; ++i, ++steps ) {
             auto itr = net_idx.begin();
             if ( itr == net_idx.end() || itr->expiration > current_time_point() ) break;
 
@@ -642,11 +660,25 @@ namespace eosiosystem {
          }
       }
 
-      /// process sellrex orders
-      if ( _rexorders.begin() != _rexorders.end() ) {
+      /// process sellrex orders, resuming at the order the previous call stopped at
+      if ( budget.sell_orders > 0 && steps < budget.steps && _rexorders.begin() != _rexorders.end() ) {
+         rex_queue_state_singleton qstate_tbl( get_self(), get_self().value );
+         auto qstate = qstate_tbl.get_or_default();
+         const auto init_qstate = qstate;
+
          auto idx  = _rexorders.get_index<"bytime"_n>();
          auto oitr = idx.begin();
-         for ( uint16_t i = 0; i < max; ++i ) {
+         if ( qstate.cursor ) {
+            /// orders with the same `by_time` key are ordered by owner
+            oitr = idx.lower_bound( qstate.cursor );
+            while ( oitr != idx.end() && oitr->by_time() == qstate.cursor && oitr->owner < qstate.cursor_owner ) {
+               ++oitr;
+            }
+            if ( oitr == idx.end() || !oitr->is_open ) {
+               oitr = idx.begin();
+            }
+         }
+         for ( uint16_t i = 0; i < budget.sell_orders && steps < budget.steps; ++i, ++steps ) {
             if ( oitr == idx.end() || !oitr->is_open ) break;
             auto next = oitr;
             ++next;
@@ -667,8 +699,18 @@ namespace eosiosystem {
             }
             oitr = next;
          }
+         /// closed orders sort last, so reaching one means every open order has been visited
+         if ( oitr == idx.end() || !oitr->is_open ) {
+            qstate.cursor       = 0;
+            qstate.cursor_owner = name();
+         } else {
+            qstate.cursor       = oitr->by_time();
+            qstate.cursor_owner = oitr->owner;
+         }
+         if ( qstate.cursor != init_qstate.cursor || qstate.cursor_owner != init_qstate.cursor_owner ) {
+            qstate_tbl.set( qstate, get_self() );
+         }
       }
-
    }
 
    /**
@@ -684,9 +726,7 @@ namespace eosiosystem {
       const uint32_t       cts            = ct.sec_since_epoch();
       const time_point_sec effective_time{cts - cts % rex_return_pool::dist_interval};
 
-      const auto ret_pool_elem    = _rexretpool.begin();
-      const auto ret_buckets_elem = _rexretbuckets.begin();
-
+      const auto ret_pool_elem = _rexretpool.begin();
       if ( ret_pool_elem == _rexretpool.end() || effective_time <= ret_pool_elem->last_dist_time ) {
          return;
       }
@@ -717,8 +757,9 @@ namespace eosiosystem {
          });
 
          if ( new_return_bucket ) {
-            _rexretbuckets.modify( ret_buckets_elem, same_payer, [&]( auto& rb ) {
-               rb.return_buckets[new_bucket_time] = new_bucket_rate;
+            _rexretbuckets.emplace( get_self(), [&]( auto& rb ) {
+               rb.bucket_time      = new_bucket_time;
+               rb.rate_of_increase = new_bucket_rate;
             });
          }
       }
@@ -727,24 +768,19 @@ namespace eosiosystem {
       if ( ret_pool_elem->oldest_bucket_time <= time_threshold ) {
          int64_t expired_rate = 0;
          int64_t surplus      = 0;
-         _rexretbuckets.modify( ret_buckets_elem, same_payer, [&]( auto& rb ) {
-            auto& return_buckets = rb.return_buckets;
-            auto iter = return_buckets.begin();
-            while ( iter != return_buckets.end() && iter->first <= time_threshold ) {
-               auto next = iter;
-               ++next;
-               const uint32_t overtime = get_elapsed_intervals( effective_time,
-                                                                iter->first + seconds(rex_return_pool::total_intervals * rex_return_pool::dist_interval) );
-               surplus      += iter->second * overtime;
-               expired_rate += iter->second;
-               return_buckets.erase(iter);
-               iter = next;
-            }
-         });
+         /// buckets are ordered by time, only the expired ones at the front are visited
+         auto iter = _rexretbuckets.begin();
+         while ( iter != _rexretbuckets.end() && iter->bucket_time <= time_threshold ) {
+            const uint32_t overtime = get_elapsed_intervals( effective_time,
+                                                             iter->bucket_time + seconds(rex_return_pool::total_intervals * rex_return_pool::dist_interval) );
+            surplus      += iter->rate_of_increase * overtime;
+            expired_rate += iter->rate_of_increase;
+            iter = _rexretbuckets.erase( iter );
+         }
 
          _rexretpool.modify( ret_pool_elem, same_payer, [&]( auto& rp ) {
-            if ( !ret_buckets_elem->return_buckets.empty() ) {
-               rp.oldest_bucket_time = ret_buckets_elem->return_buckets.begin()->first;
+            if ( iter != _rexretbuckets.end() ) {
+               rp.oldest_bucket_time = iter->bucket_time;
             } else {
                rp.oldest_bucket_time = time_point_sec::min();
             }
@@ -1011,10 +1047,9 @@ namespace eosiosystem {
     */
    time_point_sec system_contract::get_rex_maturity()
    {
-      const uint32_t num_of_maturity_buckets = 5;
       static const uint32_t now = current_time_point().sec_since_epoch();
       static const uint32_t r   = now % seconds_per_day;
-      static const time_point_sec rms{ now - r + num_of_maturity_buckets * seconds_per_day };
+      static const time_point_sec rms{ now - r + rex_balance::maturity_days * seconds_per_day };
       return rms;
    }
 
@@ -1025,15 +1060,51 @@ namespace eosiosystem {
     */
    void system_contract::process_rex_maturities( const rex_balance_table::const_iterator& bitr )
    {
-      const time_point_sec now = current_time_point();
       _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
-         while ( !rb.rex_maturities.empty() && rb.rex_maturities.front().first <= now ) {
-            rb.matured_rex += rb.rex_maturities.front().second;
-            rb.rex_maturities.pop_front();
-         }
+         advance_rex_maturities( rb );
       });
    }
 
+   /**
+    * @brief Moves every maturity slot whose day has come into `matured_rex`
+    *
+    * Slots cover the days [`maturity_day`, `maturity_day` + `maturity_days`), so at most
+    * `maturity_days` slots are visited no matter how long the balance was left untouched.
+    *
+    * @param rb - rex_balance object being modified
+    */
+   void system_contract::advance_rex_maturities( rex_balance& rb )
+   {
+      const uint32_t today = current_time_point().sec_since_epoch() / seconds_per_day;
+      if ( rb.maturity_slots.size() != rex_balance::maturity_days ) {
+         rb.maturity_slots.resize( rex_balance::maturity_days, 0 );
+      }
+      if ( rb.maturity_day > today ) {
+         return;
+      }
+      const uint32_t days = std::min( today - rb.maturity_day + 1, rex_balance::maturity_days );
+      for ( uint32_t d = 0; d < days; ++d ) {
+         auto& slot = rb.maturity_slots[ (rb.maturity_day + d) % rex_balance::maturity_days ];
+         rb.matured_rex += slot;
+         slot            = 0;
+      }
+      rb.maturity_day = today + 1;
+   }
+
+   /**
+    * @brief Adds REX to the slot of the current maturity day
+    *
+    * @param rb - rex_balance object being modified
+    * @param rex - amount of REX to be added
+    */
+   void system_contract::add_rex_maturity( rex_balance& rb, int64_t rex )
+   {
+      advance_rex_maturities( rb );
+      const uint32_t day = get_rex_maturity().sec_since_epoch() / seconds_per_day;
+      check( rb.maturity_day <= day && day < rb.maturity_day + rex_balance::maturity_days, "logic error in add_rex_maturity" );
+      rb.maturity_slots[ day % rex_balance::maturity_days ] += rex;
+   }
+
    /**
     * @brief Consolidates REX maturity buckets into one
     *
@@ -1043,19 +1114,18 @@ namespace eosiosystem {
    void system_contract::consolidate_rex_balance( const rex_balance_table::const_iterator& bitr,
                                                   const asset& rex_in_sell_order )
    {
-      const int64_t rex_in_savings = read_rex_savings( bitr );
       _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
+         advance_rex_maturities( rb );
          int64_t total  = rb.matured_rex - rex_in_sell_order.amount;
          rb.matured_rex = rex_in_sell_order.amount;
-         while ( !rb.rex_maturities.empty() ) {
-            total += rb.rex_maturities.front().second;
-            rb.rex_maturities.pop_front();
+         for ( auto& slot : rb.maturity_slots ) {
+            total += slot;
+            slot   = 0;
          }
          if ( total > 0 ) {
-            rb.rex_maturities.emplace_back( get_rex_maturity(), total );
+            add_rex_maturity( rb, total );
          }
       });
-      put_rex_savings( bitr, rex_in_savings );
    }
 
    /**
@@ -1144,7 +1214,6 @@ namespace eosiosystem {
             rp.pending_bucket_time     = effective_time;
             rp.proceeds                = fee.amount;
          });
-         _rexretbuckets.emplace( get_self(), [&]( auto& rb ) { } );
       } else {
          _rexretpool.modify( return_pool_elem, same_payer, [&]( auto& rp ) {
             rp.pending_bucket_proceeds += fee.amount;
@@ -1187,60 +1256,35 @@ namespace eosiosystem {
          current_rex_stake.amount = bitr->vote_stake.amount;
       }
 
-      const int64_t rex_in_savings = read_rex_savings( bitr );
-      process_rex_maturities( bitr );
       _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
-         const time_point_sec maturity = get_rex_maturity();
-         if ( !rb.rex_maturities.empty() && rb.rex_maturities.back().first == maturity ) {
-            rb.rex_maturities.back().second += rex_received.amount;
-         } else {
-            rb.rex_maturities.emplace_back( maturity, rex_received.amount );
-         }
+         add_rex_maturity( rb, rex_received.amount );
       });
-      put_rex_savings( bitr, rex_in_savings );
       return current_rex_stake - init_rex_stake;
    }
 
    /**
-    * @brief Reads amount of REX in savings bucket and removes the bucket from maturities
-    *
-    * Reads and (temporarily) removes REX savings bucket from REX maturities in order to
-    * allow uniform processing of remaining buckets as savings is a special case. This
-    * function is used in conjunction with put_rex_savings.
+    * @brief Reads amount of REX in savings
     *
     * @param bitr - iterator pointing to rex_balance object
     *
-    * @return int64_t - amount of REX in savings bucket
+    * @return int64_t - amount of REX in savings
     */
    int64_t system_contract::read_rex_savings( const rex_balance_table::const_iterator& bitr )
    {
-      int64_t rex_in_savings = 0;
-      static const time_point_sec end_of_days = time_point_sec::maximum();
-      if ( !bitr->rex_maturities.empty() && bitr->rex_maturities.back().first == end_of_days ) {
-         _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
-            rex_in_savings = rb.rex_maturities.back().second;
-            rb.rex_maturities.pop_back();
-         });
-      }
-      return rex_in_savings;
+      return bitr->savings_rex;
    }
 
    /**
-    * @brief Adds a specified REX amount to savings bucket
+    * @brief Sets REX savings to a specified amount
     *
     * @param bitr - iterator pointing to rex_balance object
-    * @param rex - amount of REX to be added
+    * @param rex - amount of REX in savings
     */
    void system_contract::put_rex_savings( const rex_balance_table::const_iterator& bitr, int64_t rex )
    {
-      if ( rex == 0 ) return;
-      static const time_point_sec end_of_days = time_point_sec::maximum();
+      if ( rex == bitr->savings_rex ) return;
       _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
-         if ( !rb.rex_maturities.empty() && rb.rex_maturities.back().first == end_of_days ) {
-            rb.rex_maturities.back().second += rex;
-         } else {
-            rb.rex_maturities.emplace_back( end_of_days, rex );
-         }
+         rb.savings_rex = rex;
       });
    }
 
@@ -1265,7 +1309,7 @@ namespace eosiosystem {
       }
 
       if ( delta_stake != 0 ) {
-         auto vitr = _voters.find( voter.value );
+         auto vitr = find_voter( voter );
          if ( vitr != _voters.end() ) {
             _voters.modify( vitr, same_payer, [&]( auto& vinfo ) {
                vinfo.staked += delta_stake;
@@ -63,6 +63,20 @@ namespace eosiosystem {
          });
       }
 
+      auto pv = _prodvotes.find( producer.value );
+      if ( pv != _prodvotes.end() ) {
+         if ( !pv->is_active ) {
+            _prodvotes.modify( pv, same_payer, [&]( producer_votes& v ){
+               v.is_active = true;
+            });
+         }
+      } else {
+         _prodvotes.emplace( producer, [&]( producer_votes& v ){
+            v.owner       = producer;
+            v.total_votes = prod != _producers.end() ? prod->total_votes : 0; // carry over votes of a not yet migrated row
+            v.is_active   = true;
+         });
+      }
    }
 
    void system_contract::regproducer( const name& producer, const eosio::public_key& producer_key, const std::string& url, uint16_t location ) {
@@ -90,24 +104,81 @@ namespace eosiosystem {
       _producers.modify( prod, same_payer, [&]( producer_info& info ){
          info.deactivate();
       });
+      auto pv = find_producer_votes( producer );
+      if ( pv != _prodvotes.end() ) {
+         _prodvotes.modify( pv, same_payer, [&]( producer_votes& v ){
+            v.is_active = false;
+         });
+      }
+   }
+
+   void system_contract::migrateprods( uint16_t max ) {
+      check( max > 0, "max must be positive" );
+      prodvotes_migration_singleton mig_tbl( get_self(), get_self().value );
+      check( !mig_tbl.get_or_default().done, "producer votes are already migrated" );
+      migrate_producer_votes( max );
+   }
+
+   bool system_contract::migrate_producer_votes( uint16_t max ) {
+      prodvotes_migration_singleton mig_tbl( get_self(), get_self().value );
+      auto mig = mig_tbl.get_or_default();
+      if ( mig.done ) {
+         return true;
+      }
+
+      auto prod = _producers.lower_bound( mig.cursor.value );
+      for ( uint16_t i = 0; i < max && prod != _producers.end(); ++i, ++prod ) {
+         find_producer_votes( prod->owner );
+      }
+      if ( prod == _producers.end() ) {
+         mig.done = true;
+      } else {
+         mig.cursor = prod->owner;
+      }
+      mig_tbl.set( mig, get_self() );
+      return mig.done;
+   }
+
+   producer_votes_table::const_iterator system_contract::find_producer_votes( const name& producer ) {
+      auto itr = _prodvotes.find( producer.value );
+      if ( itr != _prodvotes.end() ) {
+         return itr;
+      }
+
+      /// producers registered before the `prodvotes` table existed are moved over the first time they are touched
+      auto prod = _producers.find( producer.value );
+      if ( prod == _producers.end() ) {
+         return itr;
+      }
+      return _prodvotes.emplace( get_self(), [&]( producer_votes& v ){
+         v.owner       = prod->owner;
+         v.total_votes = prod->total_votes;
+         v.is_active   = prod->is_active;
+      });
    }
 
    void system_contract::update_elected_producers( const block_timestamp& block_time ) {
       _gstate.last_producer_schedule_update = block_time;
 
-      auto idx = _producers.get_index<"prototalvote"_n>();
+      // the ranking would miss the tallies of producers that are not in `prodvotes` yet
+      if ( !migrate_producer_votes( max_prodvotes_migration_per_schedule ) ) {
+         return;
+      }
+
+      auto idx = _prodvotes.get_index<"prototalvote"_n>();
 
       using value_type = std::pair<eosio::producer_authority, uint16_t>;
       std::vector< value_type > top_producers;
       top_producers.reserve(21);
 
       for( auto it = idx.cbegin(); it != idx.cend() && top_producers.size() < 21 && 0 < it->total_votes && it->active(); ++it ) {
+         const auto& info = _producers.get( it->owner.value, "producer not found" ); //data corruption
          top_producers.emplace_back(
             eosio::producer_authority{
-               .producer_name = it->owner,
-               .authority     = it->producer_authority
+               .producer_name = info.owner,
+               .authority     = info.producer_authority
             },
-            it->location
+            info.location
          );
       }
 
@@ -147,7 +218,35 @@ namespace eosiosystem {
       }
    }
 
+   void system_contract::votebatch( const std::vector<vote_order>& votes ) {
+      check( !votes.empty(), "no votes" );
+      check( votes.size() <= max_vote_orders, "too many votes" );
+
+      // producer vote changes of all voters are merged and every producer row is modified once
+      producer_deltas_map producer_deltas;
+      for( const auto& v : votes ) {
+         require_auth( v.voter );
+         vote_stake_updater( v.voter );
+         update_votes( v.voter, v.proxy, v.producers, true, producer_deltas );
+      }
+      apply_producer_deltas( producer_deltas, true );
+
+      for( const auto& v : votes ) {
+         auto rex_itr = _rexbalance.find( v.voter.value );
+         if( rex_itr != _rexbalance.end() && rex_itr->rex_balance.amount > 0 ) {
+            check_voting_requirement( v.voter, "voter holding REX tokens must vote for at least 21 producers or for a proxy" );
+         }
+      }
+   }
+
    void system_contract::update_votes( const name& voter_name, const name& proxy, const std::vector<name>& producers, bool voting ) {
+      producer_deltas_map producer_deltas;
+      update_votes( voter_name, proxy, producers, voting, producer_deltas );
+      apply_producer_deltas( producer_deltas, voting );
+   }
+
+   void system_contract::update_votes( const name& voter_name, const name& proxy, const std::vector<name>& producers, bool voting,
+                                       producer_deltas_map& producer_deltas ) {
       //validate input
       if ( proxy ) {
          check( producers.size() == 0, "cannot vote for producers and proxy at same time" );
@@ -159,9 +258,9 @@ namespace eosiosystem {
          }
       }
 
-      auto voter = _voters.find( voter_name.value );
+      auto voter = find_voter( voter_name );
       check( voter != _voters.end(), "user must stake before they can vote" ); /// staking creates voter object
-      check( !proxy || !voter->is_proxy, "account registered as a proxy is not allowed to use a proxy" );
+      check( !proxy || !voter->is_proxy(), "account registered as a proxy is not allowed to use a proxy" );
 
       /**
        * The first time someone votes we calculate and set last_vote_weight. Since they cannot unstake until
@@ -176,36 +275,29 @@ namespace eosiosystem {
       }
 
       auto new_vote_weight = stake2vote( voter->staked );
-      if( voter->is_proxy ) {
-         new_vote_weight += voter->proxied_vote_weight;
+      if( voter->is_proxy() ) {
+         new_vote_weight += get_proxied_vote_weight( voter_name );
       }
 
-      std::map<name, std::pair<double, bool /*new*/> > producer_deltas;
       if ( voter->last_vote_weight > 0 ) {
          if( voter->proxy ) {
-            auto old_proxy = _voters.find( voter->proxy.value );
+            auto old_proxy = find_voter( voter->proxy );
             check( old_proxy != _voters.end(), "old proxy not found" ); //data corruption
-            _voters.modify( old_proxy, same_payer, [&]( auto& vp ) {
-                  vp.proxied_vote_weight -= voter->last_vote_weight;
-               });
+            add_proxied_vote_weight( voter->proxy, -voter->last_vote_weight );
             propagate_weight_change( *old_proxy );
          } else {
             for( const auto& p : voter->producers ) {
-               auto& d = producer_deltas[p];
-               d.first -= voter->last_vote_weight;
-               d.second = false;
+               producer_deltas[p].first -= voter->last_vote_weight;
             }
          }
       }
 
       if( proxy ) {
-         auto new_proxy = _voters.find( proxy.value );
+         auto new_proxy = find_voter( proxy );
          check( new_proxy != _voters.end(), "invalid proxy specified" ); //if ( !voting ) { data corruption } else { wrong vote }
-         check( !voting || new_proxy->is_proxy, "proxy not found" );
+         check( !voting || new_proxy->is_proxy(), "proxy not found" );
          if ( new_vote_weight >= 0 ) {
-            _voters.modify( new_proxy, same_payer, [&]( auto& vp ) {
-                  vp.proxied_vote_weight += new_vote_weight;
-               });
+            add_proxied_vote_weight( proxy, new_vote_weight );
             propagate_weight_change( *new_proxy );
          }
       } else {
@@ -218,17 +310,21 @@ namespace eosiosystem {
          }
       }
 
-      const auto ct = current_time_point();
-      double delta_change_rate         = 0.0;
-      double total_inactive_vpay_share = 0.0;
+      _voters.modify( voter, same_payer, [&]( auto& av ) {
+         av.last_vote_weight = new_vote_weight;
+         av.producers = producers;
+         av.proxy     = proxy;
+      });
+   }
+
+   void system_contract::apply_producer_deltas( const producer_deltas_map& producer_deltas, bool voting ) {
       for( const auto& pd : producer_deltas ) {
-         auto pitr = _producers.find( pd.first.value );
-         if( pitr != _producers.end() ) {
+         auto pitr = find_producer_votes( pd.first );
+         if( pitr != _prodvotes.end() ) {
             if( voting && !pitr->active() && pd.second.second /* from new set */ ) {
                check( false, ( "producer " + pitr->owner.to_string() + " is not currently registered" ).data() );
             }
-            double init_total_votes = pitr->total_votes;
-            _producers.modify( pitr, same_payer, [&]( auto& p ) {
+            _prodvotes.modify( pitr, same_payer, [&]( auto& p ) {
                p.total_votes += pd.second.first;
                if ( p.total_votes < 0 ) { // floating point arithmetics can give small negative numbers
                   p.total_votes = 0;
@@ -242,58 +338,52 @@ namespace eosiosystem {
             }
          }
       }
-
-      _voters.modify( voter, same_payer, [&]( auto& av ) {
-         av.last_vote_weight = new_vote_weight;
-         av.producers = producers;
-         av.proxy     = proxy;
-      });
    }
 
    void system_contract::regproxy( const name& proxy, bool isproxy ) {
       require_auth( proxy );
 
-      auto pitr = _voters.find( proxy.value );
+      auto pitr = find_voter( proxy );
       if ( pitr != _voters.end() ) {
-         check( isproxy != pitr->is_proxy, "action has no effect" );
+         check( isproxy != pitr->is_proxy(), "action has no effect" );
          check( !isproxy || !pitr->proxy, "account that uses a proxy is not allowed to become a proxy" );
          _voters.modify( pitr, same_payer, [&]( auto& p ) {
-               p.is_proxy = isproxy;
+               p.flags1 = set_field( p.flags1, voter_info2::flags1_fields::is_proxy, isproxy );
             });
          propagate_weight_change( *pitr );
       } else {
          _voters.emplace( proxy, [&]( auto& p ) {
                p.owner  = proxy;
-               p.is_proxy = isproxy;
+               p.flags1 = set_field( p.flags1, voter_info2::flags1_fields::is_proxy, isproxy );
+            });
+      }
+      if ( isproxy && _proxies.find( proxy.value ) == _proxies.end() ) {
+         _proxies.emplace( proxy, [&]( auto& p ) {
+               p.owner = proxy;
             });
       }
    }
 
-   void system_contract::propagate_weight_change( const voter_info& voter ) {
-      check( !voter.proxy || !voter.is_proxy, "account registered as a proxy is not allowed to use a proxy" );
+   void system_contract::propagate_weight_change( const voter_info2& voter ) {
+      check( !voter.proxy || !voter.is_proxy(), "account registered as a proxy is not allowed to use a proxy" );
       double new_weight = stake2vote( voter.staked );
-      if ( voter.is_proxy ) {
-         new_weight += voter.proxied_vote_weight;
+      if ( voter.is_proxy() ) {
+         new_weight += get_proxied_vote_weight( voter.owner );
       }
 
       /// don't propagate small changes (1 ~= epsilon)
       if ( fabs( new_weight - voter.last_vote_weight ) > 1 )  {
          if ( voter.proxy ) {
-            auto& proxy = _voters.get( voter.proxy.value, "proxy not found" ); //data corruption
-            _voters.modify( proxy, same_payer, [&]( auto& p ) {
-                  p.proxied_vote_weight += new_weight - voter.last_vote_weight;
-               }
-            );
-            propagate_weight_change( proxy );
+            auto proxy = find_voter( voter.proxy );
+            check( proxy != _voters.end(), "proxy not found" ); //data corruption
+            add_proxied_vote_weight( voter.proxy, new_weight - voter.last_vote_weight );
+            propagate_weight_change( *proxy );
          } else {
             auto delta = new_weight - voter.last_vote_weight;
-            const auto ct = current_time_point();
-            double delta_change_rate         = 0;
-            double total_inactive_vpay_share = 0;
             for ( auto acnt : voter.producers ) {
-               auto& prod = _producers.get( acnt.value, "producer not found" ); //data corruption
-               const double init_total_votes = prod.total_votes;
-               _producers.modify( prod, same_payer, [&]( auto& p ) {
+               auto prod = find_producer_votes( acnt );
+               check( prod != _prodvotes.end(), "producer not found" ); //data corruption
+               _prodvotes.modify( prod, same_payer, [&]( auto& p ) {
                   p.total_votes += delta;
                   _gstate.total_producer_vote_weight += delta;
                });
@@ -307,4 +397,54 @@ namespace eosiosystem {
       );
    }
 
+   system_contract::voters2_table::const_iterator system_contract::find_voter( const name& owner ) {
+      auto itr = _voters.find( owner.value );
+      if ( itr != _voters.end() ) {
+         return itr;
+      }
+
+      /// rows written before the compact layout are moved over the first time they are touched
+      voters_table legacy( get_self(), get_self().value );
+      auto old = legacy.find( owner.value );
+      if ( old == legacy.end() ) {
+         return itr;
+      }
+
+      if ( old->is_proxy || old->proxied_vote_weight != 0 ) {
+         _proxies.emplace( get_self(), [&]( auto& p ) {
+               p.owner               = owner;
+               p.proxied_vote_weight = old->proxied_vote_weight;
+            });
+      }
+      itr = _voters.emplace( owner, [&]( auto& v ) {
+            v.owner            = owner;
+            v.proxy            = old->proxy;
+            v.producers        = old->producers;
+            v.staked           = old->staked;
+            v.last_vote_weight = old->last_vote_weight;
+            v.flags1           = set_field( old->flags1, voter_info2::flags1_fields::is_proxy, old->is_proxy );
+         });
+      legacy.erase( old );
+      return itr;
+   }
+
+   double system_contract::get_proxied_vote_weight( const name& proxy )const {
+      auto itr = _proxies.find( proxy.value );
+      return itr != _proxies.end() ? itr->proxied_vote_weight : 0;
+   }
+
+   void system_contract::add_proxied_vote_weight( const name& proxy, double delta ) {
+      auto itr = _proxies.find( proxy.value );
+      if ( itr != _proxies.end() ) {
+         _proxies.modify( itr, same_payer, [&]( auto& p ) {
+               p.proxied_vote_weight += delta;
+            });
+      } else {
+         _proxies.emplace( get_self(), [&]( auto& p ) {
+               p.owner               = proxy;
+               p.proxied_vote_weight = delta;
+            });
+      }
+   }
+
 } /// namespace eosiosystem
@@ -2,6 +2,8 @@
 
 #include <eosio/asset.hpp>
 #include <eosio/eosio.hpp>
+#include <eosio/singleton.hpp>
+#include <eosio/time.hpp>
 
 #include <string>
 
@@ -13,6 +15,17 @@ namespace eosio {
 
    using std::string;
 
+   /**
+    * One recipient of a `transfermany` action.
+    */
+   struct transfer_order {
+      name     to;
+      asset    quantity;
+      string   memo;
+
+      EOSLIB_SERIALIZE( transfer_order, (to)(quantity)(memo) )
+   };
+
    /**
     * The `amax.token` sample system contract defines the structures and actions that allow users to create, issue, and manage tokens for AMAX based blockchains. It demonstrates one way to implement a smart contract which allows for creation and management of tokens. It is possible for one to create a similar contract which suits different needs. However, it is recommended that if one only needs a token with the below listed actions, that one uses the `amax.token` contract instead of developing their own.
     * 
@@ -26,6 +39,8 @@ namespace eosio {
       public:
          using contract::contract;
 
+         static constexpr size_t max_transfer_orders = 50;
+
          /**
           * Allows `issuer` account to create a token in supply of `maximum_supply`. If validation is successful a new entry in statstable for token symbol scope gets created.
           *
@@ -64,6 +79,9 @@ namespace eosio {
           * Allows `from` account to transfer to `to` account the `quantity` tokens.
           * One account is debited and the other is credited with quantity tokens.
           *
+          * When sent inline by this contract itself, the action is the notice of one order of a
+          * `transfermany` whose balances are already settled: it only notifies `from` and `to`.
+          *
           * @param from - the account to transfer from,
           * @param to - the account to be transferred to,
           * @param quantity - the quantity of tokens to be transferred,
@@ -74,6 +92,23 @@ namespace eosio {
                         const name&    to,
                         const asset&   quantity,
                         const string&  memo );
+         /**
+          * Allows `from` account to send tokens to many accounts in one action.
+          * `from` is debited once per token symbol with the sum of its orders and every `to` account
+          * is credited with its order's quantity. For every order an inline `transfer` notice is sent,
+          * so that `from` and `to` are notified exactly as by a single `transfer` and existing
+          * `transfer` notification handlers see every order.
+          *
+          * @param from - the account to transfer from,
+          * @param transfers - the recipients, quantities and memos of the transfers.
+          *
+          * @pre `transfers` must not be empty and hold at most `max_transfer_orders` orders,
+          * @pre `from` must not be blacklisted, a blacklisted account can only use `transfer`,
+          * @pre each order has to satisfy the same checks as a single `transfer`.
+          */
+         [[eosio::action]]
+         void transfermany( const name& from, const std::vector<transfer_order>& transfers );
+
          /**
           * Allows `ram_payer` to create an account `owner` with zero balance for
           * token `symbol` at the expense of `ram_payer`.
@@ -101,6 +136,23 @@ namespace eosio {
          [[eosio::action]]
          void close( const name& owner, const symbol& symbol );
 
+         /**
+          * Folds the transfer statistics shards of token `sym` into its `transtotal` row and resets the shards.
+          * Anyone can run it.
+          *
+          * @param sym - the symbol code of the token.
+          */
+         [[eosio::action]]
+         void rollup( const symbol_code& sym );
+
+         /**
+          * Adds `targets` to or removes them from the blacklist. Added accounts are added to the blacklist summary,
+          * removals rebuild it from the `blacklist` table.
+          * On a chain whose blacklist predates the summary, calling it with no targets builds the summary.
+          *
+          * @param targets - at most 50 accounts to add or remove,
+          * @param to_add - true to add the accounts, false to remove them.
+          */
          [[eosio::action]]
          void blacklist( const std::vector<name>& targets, const bool& to_add );
 
@@ -118,7 +170,27 @@ namespace eosio {
             return ac.balance;
          }
 
+         /**
+          * Returns the transfer count and volume of token `sym_code` as a `transfer_totals`: the last rollup
+          * plus the shards not yet folded.
+          */
+         static auto get_transfer_stats( const name& token_contract_account, const symbol_code& sym_code )
+         {
+            transfer_totals_singleton totals_tbl( token_contract_account, sym_code.raw() );
+            auto totals = totals_tbl.get_or_default();
+            transfer_stats_table shards( token_contract_account, sym_code.raw() );
+            for( const auto& s : shards ) {
+               totals.transfers += s.transfers;
+               totals.volume    += s.volume;
+            }
+            return totals;
+         }
+
          static bool is_blacklisted( const name& token_contract, const name& target ) {
+            blacklist_state_singleton bl_state( token_contract, token_contract.value );
+            if( !bl_state.get_or_default().may_contain( target ) )
+               return false;
+
             blackaccounts black_accts( token_contract, token_contract.value );
             return ( black_accts.find( target.value ) != black_accts.end() );
          }
@@ -127,6 +199,8 @@ namespace eosio {
          using issue_action = eosio::action_wrapper<"issue"_n, &token::issue>;
          using retire_action = eosio::action_wrapper<"retire"_n, &token::retire>;
          using transfer_action = eosio::action_wrapper<"transfer"_n, &token::transfer>;
+         using transfermany_action = eosio::action_wrapper<"transfermany"_n, &token::transfermany>;
+         using rollup_action = eosio::action_wrapper<"rollup"_n, &token::rollup>;
          using open_action = eosio::action_wrapper<"open"_n, &token::open>;
          using close_action = eosio::action_wrapper<"close"_n, &token::close>;
       private:
@@ -150,12 +224,87 @@ namespace eosio {
             uint64_t primary_key()const { return account.value; }
          };
 
+         /**
+          * Transfer statistics shard of a token symbol. Transfers bump the shard picked by the hash of the sender,
+          * so concurrent senders do not all write the same row.
+          */
+         struct [[eosio::table]] transfer_stats {
+            uint64_t    shard;
+            uint64_t    transfers = 0;
+            uint128_t   volume    = 0;
+
+            uint64_t primary_key()const { return shard; }
+         };
+
+         static constexpr uint64_t transfer_stats_shards = 16;
+
+         /**
+          * Transfer count and volume of one token symbol, as folded by the `rollup` action.
+          * `volume` is the sum of the transferred amounts in the symbol's smallest unit.
+          */
+         struct [[eosio::table]] transfer_totals {
+            uint64_t         transfers = 0;
+            uint128_t        volume    = 0;
+            time_point_sec   last_rollup;
+
+            EOSLIB_SERIALIZE( transfer_totals, (transfers)(volume)(last_rollup) )
+         };
+
+         /**
+          * Summary of the blacklist: the number of blacklisted accounts and a bloom filter of their names,
+          * so that lookups of accounts which are not blacklisted need no probe of the `blacklist` table.
+          */
+         struct [[eosio::table]] blacklist_state {
+            uint32_t                count = 0;
+            std::vector<uint64_t>   bloom;
+
+            static constexpr uint32_t bloom_bits   = 1024;
+            static constexpr uint32_t bloom_hashes = 3;
+
+            static uint32_t bloom_bit( const name& account, uint32_t k ) {
+               static constexpr uint64_t seeds[bloom_hashes] = { 0x9e3779b97f4a7c15ull, 0xc2b2ae3d27d4eb4full, 0x165667b19e3779f9ull };
+               return uint32_t( ( account.value * seeds[k] ) >> 54 ); // top 10 bits, [0, bloom_bits)
+            }
+
+            void add( const name& account ) {
+               if( bloom.empty() ) bloom.resize( bloom_bits / 64 );
+               for( uint32_t k = 0; k < bloom_hashes; ++k ) {
+                  auto bit = bloom_bit( account, k );
+                  bloom[bit / 64] |= 1ull << ( bit % 64 );
+               }
+               ++count;
+            }
+
+            // the bits of `account` stay set until the next rebuild, they only cost a table probe
+            void remove( const name& /*account*/ ) {
+               --count;
+            }
+
+            // false only if `account` is certainly not blacklisted
+            bool may_contain( const name& account )const {
+               if( bloom.empty() ) return true; // summary not built yet, the table has to be probed
+               if( count == 0 ) return false;
+               for( uint32_t k = 0; k < bloom_hashes; ++k ) {
+                  auto bit = bloom_bit( account, k );
+                  if( !( ( bloom[bit / 64] >> ( bit % 64 ) ) & 1 ) ) return false;
+               }
+               return true;
+            }
+
+            EOSLIB_SERIALIZE( blacklist_state, (count)(bloom) )
+         };
+
          typedef eosio::multi_index< "accounts"_n, account > accounts;
          typedef eosio::multi_index< "stat"_n, currency_stats > stats;
          typedef eosio::multi_index< "blacklist"_n, blacklist_t > blackaccounts;
+         typedef eosio::singleton< "blackstate"_n, blacklist_state > blacklist_state_singleton;
+         typedef eosio::multi_index< "transtats"_n, transfer_stats > transfer_stats_table;
+         typedef eosio::singleton< "transtotal"_n, transfer_totals > transfer_totals_singleton;
 
          void sub_balance( const name& owner, const asset& value );
          void add_balance( const name& owner, const asset& value, const name& ram_payer );
+         void update_blacklist_state();
+         void add_transfer_stats( const name& from, const asset& volume, uint64_t transfers );
    };
 
 }
@@ -1,5 +1,9 @@
 #include <amax.token/amax.token.hpp>
 
+#include <eosio/system.hpp>
+
+#include <map>
+
 namespace eosio {
 
 void token::create( const name&   issuer,
@@ -80,6 +84,10 @@ void token::blacklist( const std::vector<name>& targets, const bool& to_add ){
    check( targets.size() <= 50, "overiszed targets: " + std::to_string( targets.size()) );
 
    blackaccounts black_accts( _self, _self.value );
+   blacklist_state_singleton bl_state_sing( _self, _self.value );
+   auto state = bl_state_sing.get_or_default();
+   // a summary that was never built has to be rebuilt from the whole table
+   bool rebuild = !to_add || targets.empty() || state.bloom.empty();
    if (to_add) {
       for (auto& target : targets) {
          if (black_accts.find( target.value ) != black_accts.end())
@@ -88,6 +96,7 @@ void token::blacklist( const std::vector<name>& targets, const bool& to_add ){
          black_accts.emplace( _self, [&]( auto& a ){
             a.account = target;
          });
+         state.add( target );
       }
       
    } else { //to remove
@@ -99,6 +108,20 @@ void token::blacklist( const std::vector<name>& targets, const bool& to_add ){
          black_accts.erase( itr );
       }
    }
+   if (rebuild)
+      update_blacklist_state();
+   else
+      bl_state_sing.set( state, _self );
+}
+
+void token::update_blacklist_state() {
+   blackaccounts black_accts( _self, _self.value );
+   blacklist_state state;
+   state.bloom.resize( blacklist_state::bloom_bits / 64 );
+   for( const auto& a : black_accts ) {
+      state.add( a.account );
+   }
+   blacklist_state_singleton( _self, _self.value ).set( state, _self );
 }
 
 void token::transfer( const name&    from,
@@ -106,6 +129,12 @@ void token::transfer( const name&    from,
                       const asset&   quantity,
                       const string&  memo )
 {
+   if ( get_sender() == get_self() ) {
+      // notice of a `transfermany` order, the balances are already settled
+      require_recipient( from );
+      require_recipient( to );
+      return;
+   }
 
    // check( to == "aaaaaaaaaaaa"_n || has_auth( _self ) || has_auth( "amax"_n ), "not authorized" );
    check( from != to, "cannot transfer to self" );
@@ -116,11 +145,12 @@ void token::transfer( const name&    from,
    require_auth( from );
 
    blackaccounts black_accts( _self, _self.value );
+   const auto bl_state = blacklist_state_singleton( _self, _self.value ).get_or_default();
 
    check( is_account( to ), "to account does not exist");
-   check( black_accts.find( to.value ) == black_accts.end(), "to acccount blacklisted!" );
+   check( !bl_state.may_contain( to ) || black_accts.find( to.value ) == black_accts.end(), "to acccount blacklisted!" );
 
-   auto from_black_itr = black_accts.find( from.value );
+   auto from_black_itr = bl_state.may_contain( from ) ? black_accts.find( from.value ) : black_accts.end();
    auto from_blacklisted = ( from_black_itr != black_accts.end() );
    if (from_blacklisted) {
       check( to == "aaaaaaaaaaaa"_n, "blacklisted account can only transfer to `aaaaaaaaaaaa`!" );
@@ -129,6 +159,11 @@ void token::transfer( const name&    from,
       const auto& ac = accountstable.get( symbol_code("AMAX").raw() );
       if (ac.balance == quantity) {
          black_accts.erase( from_black_itr );
+         if ( !bl_state.bloom.empty() ) {
+            auto state = bl_state;
+            state.remove( from );
+            blacklist_state_singleton( _self, _self.value ).set( state, _self );
+         }
       }
    }
 
@@ -148,6 +183,99 @@ void token::transfer( const name&    from,
 
    sub_balance( from, quantity );
    add_balance( to, quantity, payer );
+   add_transfer_stats( from, quantity, 1 );
+}
+
+void token::transfermany( const name& from, const std::vector<transfer_order>& transfers )
+{
+   require_auth( from );
+   check( !transfers.empty(), "no transfers" );
+   check( transfers.size() <= max_transfer_orders, "too many transfers" );
+
+   blackaccounts black_accts( _self, _self.value );
+   const auto bl_state = blacklist_state_singleton( _self, _self.value ).get_or_default();
+   check( !bl_state.may_contain( from ) || black_accts.find( from.value ) == black_accts.end(), "from account blacklisted!" );
+
+   std::map<symbol_code, std::pair<asset, uint64_t>> totals;
+   for( const auto& t : transfers ) {
+      check( from != t.to, "cannot transfer to self" );
+      if ( from == "aaaaaaaaaaaa"_n )
+         check( t.to == "amax"_n, "can only transfer to amax" );
+
+      check( is_account( t.to ), "to account does not exist");
+      check( !bl_state.may_contain( t.to ) || black_accts.find( t.to.value ) == black_accts.end(), "to acccount blacklisted!" );
+      check( t.quantity.is_valid(), "invalid quantity" );
+      check( t.quantity.amount > 0, "must transfer positive quantity" );
+      check( t.memo.size() <= 256, "memo has more than 256 bytes" );
+
+      auto sym = t.quantity.symbol.code();
+      auto itr = totals.find( sym );
+      if( itr == totals.end() ) {
+         stats statstable( get_self(), sym.raw() );
+         const auto& st = statstable.get( sym.raw() );
+         check( t.quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
+         totals.emplace( sym, std::make_pair( t.quantity, 1 ) );
+      } else {
+         check( t.quantity.symbol == itr->second.first.symbol, "symbol precision mismatch" );
+         itr->second.first += t.quantity;
+         ++itr->second.second;
+      }
+   }
+
+   for( const auto& total : totals ) {
+      sub_balance( from, total.second.first );
+      add_transfer_stats( from, total.second.first, total.second.second );
+   }
+
+   for( const auto& t : transfers ) {
+      auto payer = has_auth( t.to ) ? t.to : from;
+      add_balance( t.to, t.quantity, payer );
+   }
+
+   // handlers of `transfer` notifications don't know `transfermany`, notify them order by order
+   for( const auto& t : transfers ) {
+      transfer_action notice( get_self(), std::vector<permission_level>{} );
+      notice.send( from, t.to, t.quantity, t.memo );
+   }
+}
+
+void token::add_transfer_stats( const name& from, const asset& volume, uint64_t transfers ) {
+   transfer_stats_table shards( get_self(), volume.symbol.code().raw() );
+   const uint64_t shard = ( from.value * 0x9e3779b97f4a7c15ull >> 32 ) % transfer_stats_shards;
+   auto itr = shards.find( shard );
+   if( itr == shards.end() ) {
+      shards.emplace( get_self(), [&]( auto& s ) {
+         s.shard     = shard;
+         s.transfers = transfers;
+         s.volume    = volume.amount;
+      });
+   } else {
+      shards.modify( itr, same_payer, [&]( auto& s ) {
+         s.transfers += transfers;
+         s.volume    += volume.amount;
+      });
+   }
+}
+
+void token::rollup( const symbol_code& sym )
+{
+   stats statstable( get_self(), sym.raw() );
+   check( statstable.find( sym.raw() ) != statstable.end(), "token with symbol does not exist" );
+
+   transfer_totals_singleton totals_tbl( get_self(), sym.raw() );
+   auto totals = totals_tbl.get_or_default();
+   transfer_stats_table shards( get_self(), sym.raw() );
+   for( auto itr = shards.begin(); itr != shards.end(); ++itr ) {
+      if( itr->transfers == 0 ) continue;
+      totals.transfers += itr->transfers;
+      totals.volume    += itr->volume;
+      shards.modify( itr, same_payer, [&]( auto& s ) {
+         s.transfers = 0;
+         s.volume    = 0;
+      });
+   }
+   totals.last_rollup = current_time_point();
+   totals_tbl.set( totals, get_self() );
 }
 
 void token::sub_balance( const name& owner, const asset& value ) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <eosio/asset.hpp>
+#include <eosio/binary_extension.hpp>
 #include <eosio/eosio.hpp>
 
 #include <string>
@@ -27,6 +28,8 @@ namespace amax_xtoken
         using contract::contract;
 
         static constexpr uint64_t RATIO_BOOST = 10000;
+        static constexpr uint32_t MAX_BATCH_ACCOUNTS = 100;   // max accounts of freezeaccts() and feeexempts()
+        static constexpr uint64_t FEE_SHARDS = 16;            // fee rows per token in accrual mode
 
          static constexpr eosio::name active_permission{"active"_n};
 
@@ -69,8 +72,9 @@ namespace amax_xtoken
          * @param to - the account to be transferred to,
          * @param quantity - the quantity of tokens to be transferred,
          * @param memo - the memo string to accompany the transaction.
+         * @return the fee paid by `to`, zero if no fee applies.
          */
-        [[eosio::action]] void transfer(const name &from,
+        [[eosio::action]] asset transfer(const name &from,
                                         const name &to,
                                         const asset &quantity,
                                         const string &memo);
@@ -136,6 +140,25 @@ namespace amax_xtoken
          */
         [[eosio::action]] void minfee(const symbol &symbol, const asset &min_fee_quantity);
 
+        /**
+         * Set token fee accrual mode
+         * If fees accrue, a fee-bearing transfer() adds the fee to one of the FEE_SHARDS fee rows of the token,
+         * picked by the hash of `from`, instead of crediting `fee_receiver` and sending notifypayfee(),
+         * see claimfees(). The fee of each transfer is then only reported by the return value of transfer().
+         * @param symbol - the symbol of the token.
+         * @param is_fee_accrued - is fee accrued.
+         */
+        [[eosio::action]] void feeaccrual(const symbol &symbol, bool is_fee_accrued);
+
+        /**
+         * Claim accrued fees
+         * Folds the fee rows of the token, credits the sum to its current `fee_receiver` and notifies it once.
+         * Anyone can run it.
+         * @param symbol - the symbol of the token.
+         * @return the claimed fees.
+         */
+        [[eosio::action]] asset claimfees(const symbol &symbol);
+
         /**
          * set account `is fee exempt`
          * @param symbol - the symbol of the token.
@@ -144,6 +167,14 @@ namespace amax_xtoken
          */
         [[eosio::action]] void feeexempt(const symbol &symbol, const name &account, bool is_fee_exempt);
 
+        /**
+         * set accounts `is fee exempt` in batch
+         * @param symbol - the symbol of the token.
+         * @param owners - account names, at most MAX_BATCH_ACCOUNTS.
+         * @param is_fee_exempt - are accounts fee exempt.
+         */
+        [[eosio::action]] void feeexempts(const symbol &symbol, const std::vector<name> &owners, bool is_fee_exempt);
+
         /**
          * Pause token
          * If token is paused, users can not do actions: transfer(), open(), close(),
@@ -161,6 +192,14 @@ namespace amax_xtoken
          */
         [[eosio::action]] void freezeacct(const symbol &symbol, const name &account, bool is_frozen);
 
+        /**
+         * freeze accounts in batch
+         * @param symbol - the symbol of the token.
+         * @param owners - account names, at most MAX_BATCH_ACCOUNTS.
+         * @param is_frozen - are accounts frozen.
+         */
+        [[eosio::action]] void freezeaccts(const symbol &symbol, const std::vector<name> &owners, bool is_frozen);
+
         static asset get_supply(const name &token_contract_account, const symbol_code &sym_code)
         {
             stats statstable(token_contract_account, sym_code.raw());
@@ -185,9 +224,13 @@ namespace amax_xtoken
         using feeratio_action = eosio::action_wrapper<"feeratio"_n, &xtoken::feeratio>;
         using feereceiver_action = eosio::action_wrapper<"feereceiver"_n, &xtoken::feereceiver>;
         using minfee_action = eosio::action_wrapper<"minfee"_n, &xtoken::minfee>;
+        using feeaccrual_action = eosio::action_wrapper<"feeaccrual"_n, &xtoken::feeaccrual>;
+        using claimfees_action = eosio::action_wrapper<"claimfees"_n, &xtoken::claimfees>;
         using feewhitelist_action = eosio::action_wrapper<"feeexempt"_n, &xtoken::feeexempt>;
+        using feeexempts_action = eosio::action_wrapper<"feeexempts"_n, &xtoken::feeexempts>;
         using pause_action = eosio::action_wrapper<"pause"_n, &xtoken::pause>;
         using freezeacct_action = eosio::action_wrapper<"freezeacct"_n, &xtoken::freezeacct>;
+        using freezeaccts_action = eosio::action_wrapper<"freezeaccts"_n, &xtoken::freezeaccts>;
 
     private:
         struct [[eosio::table]] account
@@ -208,27 +251,48 @@ namespace amax_xtoken
             name fee_receiver;              // fee receiver
             uint64_t fee_ratio = 0;         // fee ratio, boost 10000
             asset min_fee_quantity;         // min fee quantity
+            binary_extension<bool> is_fee_accrued;   // fees accrue on fee rows until claimfees()
 
             uint64_t primary_key() const { return supply.symbol.code().raw(); }
         };
 
+        // fees of a token not yet credited to fee_receiver, scoped by symbol code
+        struct [[eosio::table]] fee_shard
+        {
+            uint64_t shard;
+            asset fees;
+
+            uint64_t primary_key() const { return shard; }
+        };
+
         typedef eosio::multi_index<"accounts"_n, account> accounts;
         typedef eosio::multi_index<"stat"_n, currency_stats> stats;
+        typedef eosio::multi_index<"feeshards"_n, fee_shard> fee_shards;
 
         template <typename Field, typename Value>
         void update_currency_field(const symbol &symbol, const Value &v, Field currency_stats::*field,
                                    currency_stats *st_out = nullptr);
 
+        void update_account_flag(const symbol &symbol, const std::vector<name> &accts, bool v, bool account::*field);
+
         void sub_balance(const currency_stats &st, const name &owner, const asset &value,
                          bool is_check_frozen = false);
         void add_balance(const currency_stats &st, const name &owner, const asset &value,
                          const name &ram_payer, bool is_check_frozen = false);
 
+        // variants for callers which already located the owner's row, `acct` may be `accts.end()` in add_balance
+        void sub_balance(const currency_stats &st, accounts &accts, const account &acct, const name &owner,
+                         const asset &value, bool is_check_frozen);
+        void add_balance(const currency_stats &st, accounts &accts, accounts::const_iterator acct, const name &owner,
+                         const asset &value, const name &ram_payer, bool is_check_frozen);
+
         inline bool is_account_frozen(const currency_stats &st, const name &owner, const account &acct) const {
             return acct.is_frozen && owner != st.issuer;
         }
 
         bool open_account(const name &owner, const symbol &symbol, const name &ram_payer);
+
+        void accrue_fee(const name &from, const asset &fee);
     };
 
 }
@@ -39,6 +39,7 @@ namespace amax_xtoken {
             s.max_supply        = maximum_supply;
             s.issuer            = issuer;
             s.min_fee_quantity  = asset(0, maximum_supply.symbol);
+            s.is_fee_accrued    = false;
         });
     }
 
@@ -93,7 +94,7 @@ namespace amax_xtoken {
         sub_balance(st, st.issuer, quantity);
     }
 
-    void xtoken::transfer(const name &from,
+    asset xtoken::transfer(const name &from,
                           const name &to,
                           const asset &quantity,
                           const string &memo)
@@ -117,6 +118,12 @@ namespace amax_xtoken {
 
         CHECK(quantity > st.min_fee_quantity, "quantity must larger than min fee:" + st.min_fee_quantity.to_string());
 
+        // each party's row is looked up once and passed on to the balance updates
+        accounts from_accts(get_self(), from.value);
+        const auto &from_acct = from_accts.get(sym_code_raw, "no balance object found");
+        accounts to_accts(get_self(), to.value);
+        auto to_acct = to_accts.find(sym_code_raw);
+
         asset actual_recv = quantity;
         asset fee = asset(0, quantity.symbol);
         if (    st.fee_receiver.value != 0
@@ -124,8 +131,6 @@ namespace amax_xtoken {
             &&  to != st.issuer
             &&  to != st.fee_receiver )
         {
-            accounts to_accts(get_self(), to.value);
-            auto to_acct = to_accts.find(sym_code_raw);
             if ( to_acct == to_accts.end() || !to_acct->is_fee_exempt)
             {
                 fee.amount = std::max( st.min_fee_quantity.amount,
@@ -137,14 +142,35 @@ namespace amax_xtoken {
 
         auto payer = has_auth(to) ? to : from;
 
-        sub_balance(st, from, quantity, true);
-        add_balance(st, to, actual_recv, payer, true);
+        sub_balance(st, from_accts, from_acct, from, quantity, true);
+        add_balance(st, to_accts, to_acct, to, actual_recv, payer, true);
 
-        if (fee.amount > 0) {
+        if (fee.amount > 0 && st.is_fee_accrued.value_or(false)) {
+            accrue_fee(from, fee);
+        } else if (fee.amount > 0) {
             add_balance(st, st.fee_receiver, fee, payer);
             notifypayfee_action notifypayfee_act{ get_self(), { {get_self(), active_permission} } };
             notifypayfee_act.send( from, to, st.fee_receiver, fee, memo );
         }
+        return fee;
+    }
+
+    void xtoken::accrue_fee(const name &from, const asset &fee)
+    {
+        // concurrent senders write different rows instead of all modifying the stat row
+        fee_shards shards(get_self(), fee.symbol.code().raw());
+        const uint64_t shard = (from.value * 0x9e3779b97f4a7c15ull >> 32) % FEE_SHARDS;
+        auto itr = shards.find(shard);
+        if (itr == shards.end()) {
+            shards.emplace(get_self(), [&](auto &s) {
+                s.shard = shard;
+                s.fees  = fee;
+            });
+        } else {
+            shards.modify(itr, same_payer, [&](auto &s) {
+                s.fees += fee;
+            });
+        }
     }
 
     /**
@@ -169,6 +195,12 @@ namespace amax_xtoken {
     {
         accounts from_accts(get_self(), owner.value);
         const auto &from = from_accts.get(value.symbol.code().raw(), "no balance object found");
+        sub_balance(st, from_accts, from, owner, value, is_check_frozen);
+    }
+
+    void xtoken::sub_balance(const currency_stats &st, accounts &from_accts, const account &from, const name &owner,
+                             const asset &value, bool is_check_frozen)
+    {
         if (is_check_frozen) {
             check(!is_account_frozen(st, owner, from), "from account is frozen");
         }
@@ -185,6 +217,12 @@ namespace amax_xtoken {
     {
         accounts to_accts(get_self(), owner.value);
         auto to = to_accts.find(value.symbol.code().raw());
+        add_balance(st, to_accts, to, owner, value, ram_payer, is_check_frozen);
+    }
+
+    void xtoken::add_balance(const currency_stats &st, accounts &to_accts, accounts::const_iterator to, const name &owner,
+                             const asset &value, const name &ram_payer, bool is_check_frozen)
+    {
         if (to == to_accts.end())
         {
             to_accts.emplace(ram_payer, [&](auto &a) {
@@ -265,39 +303,85 @@ namespace amax_xtoken {
         update_currency_field(symbol, min_fee_quantity, &currency_stats::min_fee_quantity);
     }
 
-    void xtoken::feeexempt(const symbol &symbol, const name &account, bool is_fee_exempt) {
+    void xtoken::feeaccrual(const symbol &symbol, bool is_fee_accrued) {
         auto sym_code_raw = symbol.code().raw();
         stats statstable(get_self(), sym_code_raw);
         const auto &st = statstable.get(sym_code_raw, "token of symbol does not exist");
         check(st.supply.symbol == symbol, "symbol precision mismatch");
         require_auth(st.issuer);
 
-        accounts accts(get_self(), account.value);
-        const auto &acct = accts.get(sym_code_raw, "account of token does not exist");
-
-        accts.modify(acct, st.issuer, [&](auto &a) {
-             a.is_fee_exempt = is_fee_exempt;
+        statstable.modify(st, same_payer, [&](auto &s) {
+            s.is_fee_accrued = is_fee_accrued;
         });
     }
 
+    asset xtoken::claimfees(const symbol &symbol) {
+        auto sym_code_raw = symbol.code().raw();
+        stats statstable(get_self(), sym_code_raw);
+        const auto &st = statstable.get(sym_code_raw, "token of symbol does not exist");
+        check(st.supply.symbol == symbol, "symbol precision mismatch");
+        check(st.fee_receiver.value != 0, "fee receiver not set");
+
+        asset fees(0, symbol);
+        fee_shards shards(get_self(), sym_code_raw);
+        for (auto itr = shards.begin(); itr != shards.end(); ++itr) {
+            if (itr->fees.amount == 0) continue;
+            fees += itr->fees;
+            shards.modify(itr, same_payer, [&](auto &s) {
+                s.fees.amount = 0;
+            });
+        }
+        check(fees.amount > 0, "no accrued fees");
+
+        accounts fee_accts(get_self(), st.fee_receiver.value);
+        auto fee_acct = fee_accts.find(sym_code_raw);
+        check(fee_acct != fee_accts.end(), "account of fee receiver does not exist");
+
+        add_balance(st, fee_accts, fee_acct, st.fee_receiver, fees, st.fee_receiver, false);
+        require_recipient(st.fee_receiver);
+        return fees;
+    }
+
+    void xtoken::feeexempt(const symbol &symbol, const name &account, bool is_fee_exempt) {
+        update_account_flag(symbol, {account}, is_fee_exempt, &account::is_fee_exempt);
+    }
+
+    void xtoken::feeexempts(const symbol &symbol, const std::vector<name> &owners, bool is_fee_exempt) {
+        check(!owners.empty(), "no accounts");
+        check(owners.size() <= MAX_BATCH_ACCOUNTS, "too many accounts, max " + std::to_string(MAX_BATCH_ACCOUNTS));
+        update_account_flag(symbol, owners, is_fee_exempt, &account::is_fee_exempt);
+    }
+
     void xtoken::pause(const symbol &symbol, bool is_paused)
     {
         update_currency_field(symbol, is_paused, &currency_stats::is_paused);
     }
 
     void xtoken::freezeacct(const symbol &symbol, const name &account, bool is_frozen) {
+        update_account_flag(symbol, {account}, is_frozen, &account::is_frozen);
+    }
+
+    void xtoken::freezeaccts(const symbol &symbol, const std::vector<name> &owners, bool is_frozen) {
+        check(!owners.empty(), "no accounts");
+        check(owners.size() <= MAX_BATCH_ACCOUNTS, "too many accounts, max " + std::to_string(MAX_BATCH_ACCOUNTS));
+        update_account_flag(symbol, owners, is_frozen, &account::is_frozen);
+    }
+
+    void xtoken::update_account_flag(const symbol &symbol, const std::vector<name> &accts, bool v, bool account::*field)
+    {
         auto sym_code_raw = symbol.code().raw();
         stats statstable(get_self(), sym_code_raw);
         const auto &st = statstable.get(sym_code_raw, "token of symbol does not exist");
         check(st.supply.symbol == symbol, "symbol precision mismatch");
         require_auth(st.issuer);
 
-        accounts accts(get_self(), account.value);
-        const auto &acct = accts.get(sym_code_raw, "account of token does not exist");
-
-        accts.modify(acct, st.issuer, [&](auto &a) {
-             a.is_frozen = is_frozen;
-        });
+        for (const auto &owner : accts) {
+            accounts owner_accts(get_self(), owner.value);
+            const auto &acct = owner_accts.get(sym_code_raw, "account of token does not exist");
+            owner_accts.modify(acct, st.issuer, [&](auto &a) {
+                a.*field = v;
+            });
+        }
     }
 
     template <typename Field, typename Value>
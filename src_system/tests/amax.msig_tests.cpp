@@ -149,6 +149,11 @@ public:
 
    transaction reqauth( account_name from, const vector<permission_level>& auths, const fc::microseconds& max_serialization_time );
 
+   fc::variant get_table_row( account_name scope, account_name table, uint64_t id, const string& type ) {
+      vector<char> data = get_row_by_account( N(amax.msig), scope, table, name(id) );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( type, data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+   }
+
    abi_serializer abi_ser;
 };
 
@@ -853,4 +858,163 @@ BOOST_FIXTURE_TEST_CASE( switch_proposal_and_fail_approve_with_hash, eosio_msig_
    );
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( invalidation_epoch, eosio_msig_tester ) try {
+   auto trx = reqauth( N(alice), {permission_level{N(alice), config::active_name}}, abi_serializer_max_time );
+   auto propose_and_approve = [&]( const char* proposal_name ) {
+      push_action( N(alice), N(propose), mvo()
+                     ("proposer",      "alice")
+                     ("proposal_name", proposal_name)
+                     ("trx",           trx)
+                     ("requested", vector<permission_level>{{ N(alice), config::active_name }})
+      );
+      push_action( N(alice), N(approve), mvo()
+                     ("proposer",      "alice")
+                     ("proposal_name", proposal_name)
+                     ("level",         permission_level{ N(alice), config::active_name })
+      );
+   };
+
+   propose_and_approve( "first" );
+   BOOST_REQUIRE_EQUAL( 0, get_table_row( N(alice), N(approvals2), N(first).to_uint64_t(), "approvals_info" )["inval_epoch"].as<uint64_t>() );
+
+   // an invalidation by another account bumps the epoch without invalidating alice's approval
+   push_action( N(carol), N(invalidate), mvo()
+                  ("account",      "carol")
+   );
+   BOOST_REQUIRE_EQUAL( 1, get_table_row( N(amax.msig), N(invalstate), N(invalstate).to_uint64_t(), "inval_state" )["epoch"].as<uint64_t>() );
+
+   propose_and_approve( "second" );
+   BOOST_REQUIRE_EQUAL( 1, get_table_row( N(alice), N(approvals2), N(second).to_uint64_t(), "approvals_info" )["inval_epoch"].as<uint64_t>() );
+
+   for( auto proposal_name : { "first", "second" } ) {
+      push_action( N(alice), N(exec), mvo()
+                     ("proposer",      "alice")
+                     ("proposal_name", proposal_name)
+                     ("executer",      "alice")
+      );
+   }
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( shared_transaction_blob, eosio_msig_tester ) try {
+   auto trx = reqauth( N(alice), {permission_level{N(alice), config::active_name}}, abi_serializer_max_time );
+   auto propose = [&]( account_name proposer, const string& proposal_name ) {
+      push_action( proposer, N(propose), mvo()
+                     ("proposer",      proposer)
+                     ("proposal_name", proposal_name)
+                     ("trx",           trx)
+                     ("requested", vector<permission_level>{{ N(alice), config::active_name }})
+      );
+   };
+   propose( N(alice), "first" );
+   propose( N(alice), "second" );
+   propose( N(bob), "first" );
+
+   // proposals of one proposer refer to one blob row in its scope, the proposal rows hold no transaction copy
+   auto blob = get_table_row( N(alice), N(trxblobs), 0, "trx_blob" );
+   BOOST_REQUIRE_EQUAL( 2, blob["refcount"].as<uint32_t>() );
+   BOOST_REQUIRE_EQUAL( fc::sha256::hash( trx ).str(), blob["trx_hash"].as_string() );
+   BOOST_REQUIRE( get_table_row( N(alice), N(trxblobs), 1, "trx_blob" ).is_null() );
+   BOOST_REQUIRE_EQUAL( 0, get_table_row( N(alice), N(proposal), N(first).to_uint64_t(), "proposal" )["packed_transaction"].as<bytes>().size() );
+   // another proposer of the same transaction pays for a row of its own
+   BOOST_REQUIRE_EQUAL( 1, get_table_row( N(bob), N(trxblobs), 0, "trx_blob" )["refcount"].as<uint32_t>() );
+
+   push_action( N(alice), N(approve), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("level",         permission_level{ N(alice), config::active_name })
+                  ("proposal_hash", fc::sha256::hash( trx ))
+   );
+   push_action( N(alice), N(exec), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("executer",      "alice")
+   );
+   BOOST_REQUIRE_EQUAL( 1, get_table_row( N(alice), N(trxblobs), 0, "trx_blob" )["refcount"].as<uint32_t>() );
+
+   // the last proposal of alice frees her row while bob's proposal keeps his
+   push_action( N(alice), N(cancel), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "second")
+                  ("canceler",      "alice")
+   );
+   BOOST_REQUIRE( get_table_row( N(alice), N(trxblobs), 0, "trx_blob" ).is_null() );
+   BOOST_REQUIRE_EQUAL( 1, get_table_row( N(bob), N(trxblobs), 0, "trx_blob" )["refcount"].as<uint32_t>() );
+
+   push_action( N(bob), N(cancel), mvo()
+                  ("proposer",      "bob")
+                  ("proposal_name", "first")
+                  ("canceler",      "bob")
+   );
+   BOOST_REQUIRE( get_table_row( N(bob), N(trxblobs), 0, "trx_blob" ).is_null() );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( propose_staged_transaction, eosio_msig_tester ) try {
+   auto trx = reqauth( N(alice), {permission_level{N(alice), config::active_name}}, abi_serializer_max_time );
+   auto packed = fc::raw::pack( trx );
+   auto middle = packed.begin() + packed.size() / 2;
+
+   push_action( N(alice), N(stagechunk), mvo()
+                  ("proposer",    "alice")
+                  ("upload_name", "big")
+                  ("chunk",       bytes( packed.begin(), middle ))
+   );
+   push_action( N(alice), N(stagechunk), mvo()
+                  ("proposer",    "alice")
+                  ("upload_name", "big")
+                  ("chunk",       bytes( middle, packed.end() ))
+   );
+   // every chunk is a row of its own
+   auto chunk = get_table_row( N(alice), N(stagedchunk), 0, "staged_chunk" );
+   BOOST_REQUIRE_EQUAL( 0, chunk["seq"].as<uint32_t>() );
+   BOOST_REQUIRE( bytes( packed.begin(), middle ) == chunk["chunk"].as<bytes>() );
+   chunk = get_table_row( N(alice), N(stagedchunk), 1, "staged_chunk" );
+   BOOST_REQUIRE_EQUAL( 1, chunk["seq"].as<uint32_t>() );
+   BOOST_REQUIRE( bytes( middle, packed.end() ) == chunk["chunk"].as<bytes>() );
+
+   push_action( N(alice), N(propstaged), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("requested",     vector<permission_level>{{ N(alice), config::active_name }})
+                  ("upload_name",   "big")
+   );
+   BOOST_REQUIRE( get_table_row( N(alice), N(stagedchunk), 0, "staged_chunk" ).is_null() );
+   BOOST_REQUIRE( get_table_row( N(alice), N(stagedchunk), 1, "staged_chunk" ).is_null() );
+
+   push_action( N(alice), N(approve), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("level",         permission_level{ N(alice), config::active_name })
+   );
+
+   transaction_trace_ptr trace;
+   control->applied_transaction.connect(
+   [&]( std::tuple<const transaction_trace_ptr&, const signed_transaction&> p ) {
+      const auto& t = std::get<0>(p);
+      if( t->scheduled ) { trace = t; }
+   } );
+
+   push_action( N(alice), N(exec), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("executer",      "alice")
+   );
+
+   BOOST_REQUIRE( bool(trace) );
+   BOOST_REQUIRE_EQUAL( 1, trace->action_traces.size() );
+   BOOST_REQUIRE_EQUAL( transaction_receipt::executed, trace->receipt->status );
+
+   // a staged transaction can be dropped instead of proposed
+   push_action( N(alice), N(stagechunk), mvo()
+                  ("proposer",    "alice")
+                  ("upload_name", "big")
+                  ("chunk",       packed)
+   );
+   BOOST_REQUIRE( !get_table_row( N(alice), N(stagedchunk), 0, "staged_chunk" ).is_null() );
+   push_action( N(alice), N(dropstaged), mvo()
+                  ("proposer",    "alice")
+                  ("upload_name", "big")
+   );
+   BOOST_REQUIRE( get_table_row( N(alice), N(stagedchunk), 0, "staged_chunk" ).is_null() );
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -69,14 +69,28 @@ FC_REFLECT(powerup_state_resource,
            (initial_timestamp)(target_timestamp)(exponent)(decay_secs)(min_price)(max_price)(utilization)   //
            (adjusted_utilization)(utilization_timestamp))
 
+struct powerup_price_table {
+   vector<int64_t> prices;
+   vector<int64_t> integrals;
+};
+FC_REFLECT(powerup_price_table, (prices)(integrals))
+
+struct powerup_price_tables {
+   powerup_price_table net;
+   powerup_price_table cpu;
+};
+FC_REFLECT(powerup_price_tables, (net)(cpu))
+
+// every state read here was written by cfgpowerup, so the price_tables extension is always present
 struct powerup_state {
    uint8_t               version;
    powerup_state_resource net;
    powerup_state_resource cpu;
    uint32_t              powerup_days;
    asset                 min_powerup_fee;
+   powerup_price_tables  price_tables;
 };
-FC_REFLECT(powerup_state, (version)(net)(cpu)(powerup_days)(min_powerup_fee))
+FC_REFLECT(powerup_state, (version)(net)(cpu)(powerup_days)(min_powerup_fee)(price_tables))
 
 using namespace eosio_system;
 
@@ -185,6 +199,11 @@ struct powerup_tester : eosio_system_tester {
                                "cpu_frac", cpu_frac)("max_payment", max_payment));
    }
 
+   action_result powerupmany(const name& payer, const vector<mvo>& receivers, const asset& max_payment) {
+      return push_action(payer, N(powerupmany),
+                         mvo()("payer", payer)("receivers", receivers)("max_payment", max_payment));
+   }
+
    powerup_state get_state() {
       vector<char> data = get_row_by_account(config::system_account_name, {}, N(powup.state), N(powup.state));
       return fc::raw::unpack<powerup_state>(data);
@@ -375,6 +394,34 @@ BOOST_FIXTURE_TEST_CASE(config_tests, powerup_tester) try {
 } // config_tests
 FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE(price_table_tests, powerup_tester) try {
+   // exponents 1, 2 and 3 are evaluated in closed form and carry no table
+   BOOST_REQUIRE_EQUAL("", configbw(make_config([](auto& c) { c.cpu.exponent = 3; })));
+   BOOST_REQUIRE_EQUAL(0, get_state().price_tables.net.prices.size());
+   BOOST_REQUIRE_EQUAL(0, get_state().price_tables.cpu.prices.size());
+
+   BOOST_REQUIRE_EQUAL("", configbw(make_config([](auto& c) { c.net.exponent = 2.5; })));
+   auto state = get_state();
+   const auto& table = state.price_tables.net;
+   BOOST_REQUIRE_EQUAL(65, table.prices.size());
+   BOOST_REQUIRE_EQUAL(state.net.min_price.get_amount(), table.prices.front());
+   BOOST_REQUIRE_EQUAL(state.net.max_price.get_amount(), table.prices.back());
+   BOOST_REQUIRE_EQUAL(int64_t(state.net.max_price.get_amount() * std::pow(0.5, 1.5) + 0.5), table.prices[32]);
+   // integrals are the running trapezoid sums of the prices
+   BOOST_REQUIRE_EQUAL(65, table.integrals.size());
+   BOOST_REQUIRE_EQUAL(0, table.integrals.front());
+   int64_t sum = 0;
+   for (size_t i = 0; i < 64; ++i)
+      sum += table.prices[i] + table.prices[i + 1];
+   BOOST_REQUIRE_EQUAL(sum, table.integrals.back());
+   BOOST_REQUIRE_EQUAL(0, state.price_tables.cpu.prices.size());
+
+   // reconfiguring back to an integer exponent drops the table
+   BOOST_REQUIRE_EQUAL("", configbw(make_config([](auto& c) { c.net.exponent = 2; })));
+   BOOST_REQUIRE_EQUAL(0, get_state().price_tables.net.prices.size());
+} // price_table_tests
+FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE(weight_tests, powerup_tester) try {
    produce_block();
 
@@ -867,6 +914,105 @@ BOOST_AUTO_TEST_CASE(rent_tests) try {
 } // rent_tests
 FC_LOG_AND_RETHROW()
 
+BOOST_AUTO_TEST_CASE(order_bucket_tests) try {
+   powerup_tester t;
+   t.produce_block();
+   BOOST_REQUIRE_EQUAL("", t.configbw(t.make_config([&](auto& config) {
+      config.net.current_weight_ratio = powerup_frac / 2;
+      config.net.target_weight_ratio  = powerup_frac / 2;
+      config.cpu.current_weight_ratio = powerup_frac / 2;
+      config.cpu.target_weight_ratio  = powerup_frac / 2;
+   })));
+   t.start_rex();
+   for (auto acc : { N(aaaaaaaaaaaa), N(bbbbbbbbbbbb), N(cccccccccccc) })
+      t.create_account_with_resources(acc, config::system_account_name, core_sym::from_string("10000.0000"), false,
+                                      core_sym::from_string("500.0000"), core_sym::from_string("500.0000"));
+   t.transfer(config::system_account_name, N(aaaaaaaaaaaa), core_sym::from_string("1000000.0000"));
+
+   auto order_row = [&](uint64_t id) {
+      return t.get_row_by_account(config::system_account_name, {}, N(powup.order), account_name(id));
+   };
+
+   // two powerups for the same receiver on the same day share one expiry bucket
+   BOOST_REQUIRE_EQUAL("", t.powerup(N(aaaaaaaaaaaa), N(bbbbbbbbbbbb), 30, powerup_frac / 100, powerup_frac / 100,
+                                    asset::from_string("100000.0000 TST")));
+   t.produce_block(fc::hours(1));
+   BOOST_REQUIRE_EQUAL("", t.powerup(N(aaaaaaaaaaaa), N(bbbbbbbbbbbb), 30, powerup_frac / 100, powerup_frac / 100,
+                                    asset::from_string("100000.0000 TST")));
+   BOOST_REQUIRE(!order_row(0).empty());
+   BOOST_REQUIRE(order_row(1).empty());
+
+   // a different receiver gets its own bucket
+   BOOST_REQUIRE_EQUAL("", t.powerup(N(aaaaaaaaaaaa), N(cccccccccccc), 30, powerup_frac / 100, powerup_frac / 100,
+                                    asset::from_string("100000.0000 TST")));
+   BOOST_REQUIRE(!order_row(1).empty());
+
+   // the bucket is released as a whole once its latest order expires
+   auto before = t.get_state();
+   t.produce_block(fc::days(30));
+   BOOST_REQUIRE_EQUAL("", t.powerupexec(config::system_account_name, 10));
+   BOOST_REQUIRE(order_row(0).empty());
+   BOOST_REQUIRE(order_row(1).empty());
+   BOOST_REQUIRE_EQUAL(0, t.get_state().net.utilization);
+   BOOST_REQUIRE_EQUAL(0, t.get_state().cpu.utilization);
+   BOOST_REQUIRE(before.net.utilization > 0);
+} // order_bucket_tests
+FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE(powerupmany_tests) try {
+   powerup_tester t;
+   t.produce_block();
+   BOOST_REQUIRE_EQUAL("", t.configbw(t.make_config([&](auto& config) {
+      config.net.current_weight_ratio = powerup_frac / 2;
+      config.net.target_weight_ratio  = powerup_frac / 2;
+      config.cpu.current_weight_ratio = powerup_frac / 2;
+      config.cpu.target_weight_ratio  = powerup_frac / 2;
+   })));
+   t.start_rex();
+   for (auto acc : { N(aaaaaaaaaaaa), N(bbbbbbbbbbbb), N(cccccccccccc) })
+      t.create_account_with_resources(acc, config::system_account_name, core_sym::from_string("10000.0000"), false,
+                                      core_sym::from_string("500.0000"), core_sym::from_string("500.0000"));
+   t.transfer(config::system_account_name, N(aaaaaaaaaaaa), core_sym::from_string("1000000.0000"));
+
+   auto receiver = [](name acc, int64_t net_frac, int64_t cpu_frac) {
+      return mvo()("receiver", acc)("net_frac", net_frac)("cpu_frac", cpu_frac);
+   };
+
+   BOOST_REQUIRE_EQUAL(t.wasm_assert_msg("no receivers"),
+                       t.powerupmany(N(aaaaaaaaaaaa), {}, asset::from_string("1000.0000 TST")));
+   BOOST_REQUIRE_EQUAL(t.wasm_assert_msg("receiver account does not exist"),
+                       t.powerupmany(N(aaaaaaaaaaaa), { receiver(N(nonexistent), powerup_frac / 100, 0) },
+                                     asset::from_string("1000.0000 TST")));
+   BOOST_REQUIRE_EQUAL(t.wasm_assert_msg("calculated fee is below minimum; try powering up with more resources"),
+                       t.powerupmany(N(aaaaaaaaaaaa),
+                                     { receiver(N(bbbbbbbbbbbb), powerup_frac / 100, 0), receiver(N(cccccccccccc), 0, 0) },
+                                     asset::from_string("1000000.0000 TST")));
+
+   // two equal receivers cost the same as one powerup of twice the size, split evenly
+   auto before_b = t.get_account_info(N(bbbbbbbbbbbb));
+   auto before_c = t.get_account_info(N(cccccccccccc));
+   auto before_a = t.get_balance(N(aaaaaaaaaaaa));
+   auto before   = t.get_state();
+   BOOST_REQUIRE_EQUAL("", t.powerupmany(N(aaaaaaaaaaaa),
+                                         { receiver(N(bbbbbbbbbbbb), powerup_frac / 100, powerup_frac / 100),
+                                           receiver(N(cccccccccccc), powerup_frac / 100, powerup_frac / 100) },
+                                         asset::from_string("1000000.0000 TST")));
+   auto after  = t.get_state();
+   auto net    = int64_t(eosio::chain::int128_t(powerup_frac / 100) * before.net.weight / powerup_frac);
+   auto cpu    = int64_t(eosio::chain::int128_t(powerup_frac / 100) * before.cpu.weight / powerup_frac);
+   BOOST_REQUIRE_EQUAL(2 * net, after.net.utilization - before.net.utilization);
+   BOOST_REQUIRE_EQUAL(2 * cpu, after.cpu.utilization - before.cpu.utilization);
+   BOOST_REQUIRE_EQUAL(net, t.get_account_info(N(bbbbbbbbbbbb)).net - before_b.net);
+   BOOST_REQUIRE_EQUAL(cpu, t.get_account_info(N(cccccccccccc)).cpu - before_c.cpu);
+   auto paid = before_a - t.get_balance(N(aaaaaaaaaaaa));
+   BOOST_REQUIRE(paid.get_amount() > 0);
+
+   // one order bucket per receiver
+   BOOST_REQUIRE(!t.get_row_by_account(config::system_account_name, {}, N(powup.order), account_name(1)).empty());
+   BOOST_REQUIRE(t.get_row_by_account(config::system_account_name, {}, N(powup.order), account_name(2)).empty());
+} // powerupmany_tests
+FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
 
 #endif// ENABLED_REX
\ No newline at end of file
@@ -272,6 +272,10 @@ public:
       return buyrambytes( account_name(payer), account_name(receiver), numbytes );
    }
 
+   action_result buyrambatch( const account_name& payer, const vector<mutable_variant_object>& orders ) {
+      return push_action( payer, N(buyrambatch), mvo()( "payer",payer)("orders",orders) );
+   }
+
    action_result sellram( const account_name& account, uint64_t numbytes ) {
       return push_action( account, N(sellram), mvo()( "account", account)("bytes",numbytes) );
    }
@@ -310,6 +314,10 @@ public:
       return stake( account_name(acnt), net, cpu );
    }
 
+   action_result delegatebatch( const account_name& from, const vector<mutable_variant_object>& orders ) {
+      return push_action( name(from), N(delegatebatch), mvo()( "from", from)("orders", orders) );
+   }
+
    action_result stake_with_transfer( const account_name& from, const account_name& to, const asset& net, const asset& cpu ) {
       return push_action( name(from), N(delegatebw), mvo()
                           ("from",     from)
@@ -349,8 +357,12 @@ public:
       return unstake( account_name(acnt), net, cpu );
    }
 
-   int64_t bancor_convert( int64_t S, int64_t R, int64_t T ) { return double(R) * T  / ( double(S) + T ); };
-   int64_t get_bancor_input( int64_t S, int64_t R, int64_t T ) { return double(R) * T  / ( double(S) - T ); };
+   // mirror the contract's 128-bit integer Bancor kernel
+   int64_t bancor_convert( int64_t S, int64_t R, int64_t T ) { return int64_t( ( eosio::chain::uint128_t(R) * T ) / ( eosio::chain::uint128_t(S) + T ) ); };
+   int64_t get_bancor_input( int64_t S, int64_t R, int64_t T ) { return int64_t( ( eosio::chain::uint128_t(R) * T ) / eosio::chain::uint128_t( S - T ) ); };
+   // former floating point kernel, kept for differential testing
+   int64_t bancor_convert_double( int64_t S, int64_t R, int64_t T ) { return double(R) * T  / ( double(S) + T ); };
+   int64_t get_bancor_input_double( int64_t S, int64_t R, int64_t T ) { return double(R) * T  / ( double(S) - T ); };
 
    int64_t get_net_limit( account_name a ) {
       int64_t ram_bytes = 0, net = 0, cpu = 0;
@@ -554,6 +566,11 @@ public:
       return push_action( name(user), N(rexexec), mvo()("user", user)("max", max) );
    }
 
+   action_result rexrun( const account_name& user, uint16_t max_cpu_loans, uint16_t max_net_loans, uint16_t max_sell_orders, uint32_t max_steps ) {
+      return push_action( name(user), N(rexrun), mvo()("user", user)("max_cpu_loans", max_cpu_loans)("max_net_loans", max_net_loans)
+                                                      ("max_sell_orders", max_sell_orders)("max_steps", max_steps) );
+   }
+
    action_result consolidate( const account_name& owner ) {
       return push_action( name(owner), N(consolidate), mvo()("owner", owner) );
    }
@@ -633,6 +650,15 @@ public:
       return data.empty() ? fc::variant() : abi_ser.binary_to_variant("rex_balance", data, abi_serializer::create_yield_function(abi_serializer_max_time));
    }
 
+   // number of non-empty maturity buckets, savings included
+   static size_t rex_maturity_count( const fc::variant& rex_balance ) {
+      size_t count = rex_balance["savings_rex"].as<int64_t>() > 0 ? 1 : 0;
+      for( const auto& slot : rex_balance["maturity_slots"].get_array() ) {
+         if( slot.as<int64_t>() > 0 ) ++count;
+      }
+      return count;
+   }
+
    asset get_rex_fund( const account_name& act ) const {
       vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, N(rexfund), act );
       return data.empty() ? asset(0, symbol{CORE_SYM}) : abi_ser.binary_to_variant("rex_fund", data, abi_serializer::create_yield_function(abi_serializer_max_time))["balance"].as<asset>();
@@ -700,25 +726,23 @@ public:
       return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "rex_return_pool", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
    }
 
+   // all rows of the `retbucket` table, in the shape of the former single-row `return_buckets` map
    fc::variant get_rex_return_buckets() const {
-      vector<char> data;
       const auto& db = control->db();
       namespace chain = eosio::chain;
-      const auto* t_id = db.find<eosio::chain::table_id_object, chain::by_code_scope_table>( boost::make_tuple( config::system_account_name, config::system_account_name, N(retbuckets) ) );
+      const auto* t_id = db.find<eosio::chain::table_id_object, chain::by_code_scope_table>( boost::make_tuple( config::system_account_name, config::system_account_name, N(retbucket) ) );
+      fc::variants buckets;
       if ( !t_id ) {
-         return fc::variant();
+         return mvo()("return_buckets", buckets);
       }
 
       const auto& idx = db.get_index<chain::key_value_index, chain::by_scope_primary>();
-
-      auto itr = idx.lower_bound( boost::make_tuple( t_id->id, 0 ) );
-      if ( itr == idx.end() || itr->t_id != t_id->id || 0 != itr->primary_key ) {
-         return fc::variant();
+      for( auto itr = idx.lower_bound( boost::make_tuple( t_id->id, 0 ) ); itr != idx.end() && itr->t_id == t_id->id; ++itr ) {
+         vector<char> data( itr->value.size() );
+         memcpy( data.data(), itr->value.data(), data.size() );
+         buckets.push_back( abi_ser.binary_to_variant( "rex_return_bucket", data, abi_serializer::create_yield_function(abi_serializer_max_time) ) );
       }
-
-      data.resize( itr->value.size() );
-      memcpy( data.data(), itr->value.data(), data.size() );
-      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "rex_return_buckets", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+      return mvo()("return_buckets", buckets);
    }
 
 // TODO: FIXME: to upgrade it in the future!!!
@@ -760,6 +784,10 @@ public:
       return bidname( account_name(bidder), account_name(newname), bid );
    }
 
+   action_result bidwithdraw( const account_name& bidder ) {
+      return push_action( name(bidder), N(bidwithdraw), mvo()("bidder", bidder) );
+   }
+
    static fc::variant_object producer_parameters_example( int n ) {
       return mutable_variant_object()
          ("max_block_net_usage", 10000000 + n )
@@ -804,6 +832,26 @@ public:
       return vote( voter, producers, account_name(proxy) );
    }
 
+   action_result votebatch( const vector<mutable_variant_object>& votes ) {
+      vector<permission_level> auths;
+      for( const auto& v : votes ) {
+         auths.push_back( { v["voter"].as<account_name>(), config::active_name } );
+      }
+      signed_transaction trx;
+      trx.actions.emplace_back( get_action( config::system_account_name, N(votebatch), auths, mvo()("votes", votes) ) );
+      set_transaction_headers( trx );
+      for( const auto& a : auths ) {
+         trx.sign( get_private_key( a.actor, "active" ), control->get_chain_id() );
+      }
+      try {
+         push_transaction( trx );
+      } catch( const fc::exception& ex ) {
+         edump( (ex.to_detail_string()) );
+         return error( ex.top_message() );
+      }
+      return success();
+   }
+
    uint32_t last_block_time() const {
       return time_point_sec( control->head_block_time() ).sec_since_epoch();
    }
@@ -826,16 +874,41 @@ public:
    }
 
    fc::variant get_voter_info( const account_name& act ) {
-      vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, N(voters), act );
-      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "voter_info", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+      vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, N(voters2), act );
+      if( data.empty() ) return fc::variant();
+      fc::variant info = abi_ser.binary_to_variant( "voter_info2", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+      // expose the legacy `voter_info` view: proxy flag out of `flags1`, proxied weight from the `proxies` table
+      const uint32_t flags1 = info["flags1"].as<uint32_t>();
+      double proxied_vote_weight = 0;
+      data = get_row_by_account( config::system_account_name, config::system_account_name, N(proxies), act );
+      if( !data.empty() ) {
+         proxied_vote_weight = abi_ser.binary_to_variant( "proxy_info", data, abi_serializer::create_yield_function(abi_serializer_max_time) )["proxied_vote_weight"].as_double();
+      }
+      return mvo( info )
+         ("flags1", flags1 & ~0x80000000u)
+         ("is_proxy", (flags1 & 0x80000000u) != 0)
+         ("proxied_vote_weight", proxied_vote_weight);
    }
    fc::variant get_voter_info(  std::string_view act ) {
       return get_voter_info( account_name(act) );
    }
 
+   fc::variant get_producer_votes( const account_name& act ) {
+      vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, N(prodvotes), act );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "producer_votes", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+   }
+
+   // producer metadata merged with the vote tally kept in the `prodvotes` table
    fc::variant get_producer_info( const account_name& act ) {
       vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, N(producers), act );
-      return abi_ser.binary_to_variant( "producer_info", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+      fc::variant info = abi_ser.binary_to_variant( "producer_info", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+      fc::variant votes = get_producer_votes( act );
+      if( votes.is_null() ) {
+         return info;
+      }
+      return mvo( info )
+         ("total_votes", votes["total_votes"])
+         ("is_active",   votes["is_active"]);
    }
    fc::variant get_producer_info( std::string_view act ) {
       return get_producer_info( account_name(act) );
@@ -962,6 +1035,11 @@ public:
       return data.empty() ? fc::variant() : abi_ser.binary_to_variant("name_bid", data, abi_serializer::create_yield_function(abi_serializer_max_time));
    }
 
+   fc::variant get_bid_balance( const account_name& bidder ) const {
+      vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, N(bidbalances), bidder );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant("bid_balance", data, abi_serializer::create_yield_function(abi_serializer_max_time));
+   }
+
    using resource_limits_state_object = eosio::chain::resource_limits::resource_limits_state_object;
 
    resource_limits_state_object get_resource_limits_state() {
@@ -49,18 +49,15 @@ struct _delegated_bandwidth {
 FC_REFLECT( _delegated_bandwidth, (from)(to)(net_weight)(cpu_weight) )
 
 struct _voter_info {
+   uint8_t             version = 0;
    name                owner;
    name                proxy;
    std::vector<name>   producers;
    int64_t             staked = 0;
    double              last_vote_weight = 0;
-   double              proxied_vote_weight= 0;
-   bool                is_proxy = 0;
    uint32_t            flags1 = 0;
-   uint32_t            reserved2 = 0;
-   asset        reserved3;
 };
-FC_REFLECT( _voter_info, (owner)(proxy)(producers)(staked)(last_vote_weight)(proxied_vote_weight)(is_proxy)(flags1)(reserved2)(reserved3) )
+FC_REFLECT( _voter_info, (version)(owner)(proxy)(producers)(staked)(last_vote_weight)(flags1) )
 
 struct _token_account {
    asset    balance;
@@ -221,7 +218,7 @@ BOOST_AUTO_TEST_CASE( newaccount ) try {
    auto delegatebw_receiver_ram_size = get_billable_size(_delegated_bandwidth(), true) // delegated_bandwidth for receiver of delegatebw
                                      + get_billable_size(_voter_info()); // voter_info for receiver of delegatebw, transfer=1
    dump_ram((delegatebw_receiver_ram_size));
-   BOOST_REQUIRE_EQUAL(delegatebw_receiver_ram_size, 450);
+   BOOST_REQUIRE_EQUAL(delegatebw_receiver_ram_size, 422);
 
    created_acct_payed_ram = newaccount_native_ram_size + newaccount_amax_ram_size + delegatebw_receiver_ram_size;
    dump_ram((created_acct_payed_ram));
@@ -460,6 +457,83 @@ BOOST_FIXTURE_TEST_CASE( buysell, eosio_system_tester ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( buyram_bancor_fixed_point, eosio_system_tester ) try {
+   transfer( "amax", "alice1111111", core_sym::from_string("100000000.0000"), "amax" );
+
+   // every purchase must match the integer kernel exactly and the former double kernel within one byte
+   const std::vector<std::string> quants = { "0.0100", "0.9999", "1.0000", "7.7777", "123.4567", "10000.0000", "1234567.8901", "50000000.0000" };
+   for( const auto& q : quants ) {
+      const asset quant = core_sym::from_string(q);
+      auto ram_market = get_ram_market();
+      const int64_t base_reserve  = ram_market["base"].as<connector>().balance.get_amount();
+      const int64_t quote_reserve = ram_market["quote"].as<connector>().balance.get_amount();
+      const int64_t quant_after_fee = quant.get_amount() - (quant.get_amount() + 199) / 200;
+      const int64_t expected        = bancor_convert( quote_reserve, base_reserve, quant_after_fee );
+      const int64_t expected_double = bancor_convert_double( quote_reserve, base_reserve, quant_after_fee );
+
+      const auto init_bytes = get_total_stake( "alice1111111" )["ram_bytes"].as_int64();
+      BOOST_REQUIRE_EQUAL( success(), buyram( "alice1111111", "alice1111111", quant ) );
+      const auto bought = get_total_stake( "alice1111111" )["ram_bytes"].as_int64() - init_bytes;
+
+      BOOST_REQUIRE_EQUAL( expected, bought );
+      BOOST_REQUIRE( within_one( expected_double, bought ) );
+   }
+
+   // cost of an exact number of bytes
+   auto ram_market = get_ram_market();
+   const int64_t base_reserve  = ram_market["base"].as<connector>().balance.get_amount();
+   const int64_t quote_reserve = ram_market["quote"].as<connector>().balance.get_amount();
+   for( int64_t bytes : { int64_t(1), int64_t(4096), int64_t(1024 * 1024), base_reserve / 3 } ) {
+      BOOST_REQUIRE( within_one( get_bancor_input_double( base_reserve, quote_reserve, bytes ),
+                                 get_bancor_input( base_reserve, quote_reserve, bytes ) ) );
+   }
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( buyrambatch_orders, eosio_system_tester ) try {
+   transfer( "amax", "alice1111111", core_sym::from_string("10000.0000"), "amax" );
+   auto order = []( std::string_view receiver, const asset& quant, uint32_t bytes ) {
+      return mvo()("receiver", receiver)("quant", quant)("bytes", bytes);
+   };
+   const asset zero = core_sym::from_string("0.0000");
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("no orders"), buyrambatch( N(alice1111111), {} ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("exactly one of quant and bytes must be set"),
+                        buyrambatch( N(alice1111111), { order( "bob111111111", core_sym::from_string("1.0000"), 100 ) } ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("exactly one of quant and bytes must be set"),
+                        buyrambatch( N(alice1111111), { order( "bob111111111", zero, 0 ) } ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("too many orders"),
+                        buyrambatch( N(alice1111111), vector<mvo>( 101, order( "bob111111111", core_sym::from_string("0.0100"), 0 ) ) ) );
+
+   auto ram_market = get_ram_market();
+   const int64_t base_reserve  = ram_market["base"].as<connector>().balance.get_amount();
+   const int64_t quote_reserve = ram_market["quote"].as<connector>().balance.get_amount();
+   const int64_t bytes_cost    = int64_t( get_bancor_input( base_reserve, quote_reserve, 4096 ) / double(0.995) );
+   const std::vector<int64_t> quants = { 1000000, bytes_cost, 500000 };
+   std::vector<int64_t> paid;
+   int64_t total_paid = 0, total_quant = 0;
+   for( auto q : quants ) {
+      paid.push_back( q - (q + 199) / 200 );
+      total_paid  += paid.back();
+      total_quant += q;
+   }
+   const int64_t bytes_out  = bancor_convert( quote_reserve, base_reserve, total_paid );
+   const int64_t bob_bytes0 = int64_t( ( eosio::chain::uint128_t(bytes_out) * paid[0] ) / total_paid );
+   const int64_t carol_bytes = int64_t( ( eosio::chain::uint128_t(bytes_out) * paid[1] ) / total_paid );
+
+   const asset alice_balance = get_balance( "alice1111111" );
+   const auto  bob_bytes     = get_total_stake( "bob111111111" )["ram_bytes"].as_int64();
+   const auto  carol_bytes0  = get_total_stake( "carol1111111" )["ram_bytes"].as_int64();
+   BOOST_REQUIRE_EQUAL( success(), buyrambatch( N(alice1111111), { order( "bob111111111", core_sym::from_string("100.0000"), 0 ),
+                                                                   order( "carol1111111", zero, 4096 ),
+                                                                   order( "bob111111111", core_sym::from_string("50.0000"), 0 ) } ) );
+
+   BOOST_REQUIRE_EQUAL( alice_balance - asset( total_quant, CORE_SYMBOL ), get_balance( "alice1111111" ) );
+   BOOST_REQUIRE_EQUAL( carol_bytes, get_total_stake( "carol1111111" )["ram_bytes"].as_int64() - carol_bytes0 );
+   BOOST_REQUIRE_EQUAL( bytes_out - carol_bytes, get_total_stake( "bob111111111" )["ram_bytes"].as_int64() - bob_bytes );
+   BOOST_REQUIRE( bob_bytes0 < bytes_out - carol_bytes );
+   BOOST_REQUIRE( within_error( 4096, carol_bytes, 41 ) );
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE( stake_unstake, eosio_system_tester ) try {
    cross_15_percent_threshold();
 
@@ -487,9 +561,11 @@ BOOST_FIXTURE_TEST_CASE( stake_unstake, eosio_system_tester ) try {
    produce_blocks(1);
    BOOST_REQUIRE_EQUAL( core_sym::from_string("700.0000"), get_balance( "alice1111111" ) );
    BOOST_REQUIRE_EQUAL( init_eosio_stake_balance + core_sym::from_string("300.0000"), get_balance( N(amax.stake) ) );
-   //after 3 days funds should be released
+   //after 3 days funds can be released
    produce_block( fc::hours(1) );
    produce_blocks(1);
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("700.0000"), get_balance( "alice1111111" ) );
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(bob111111111), N(processrefunds), mvo()("max", 10) ) );
    BOOST_REQUIRE_EQUAL( core_sym::from_string("1000.0000"), get_balance( "alice1111111" ) );
    BOOST_REQUIRE_EQUAL( init_eosio_stake_balance, get_balance( N(amax.stake) ) );
 
@@ -516,13 +592,68 @@ BOOST_FIXTURE_TEST_CASE( stake_unstake, eosio_system_tester ) try {
    produce_block( fc::hours(3*24-1) );
    produce_blocks(1);
    BOOST_REQUIRE_EQUAL( core_sym::from_string("700.0000"), get_balance( "alice1111111" ) );
-   //after 3 days funds should be released
+   //after 3 days funds can be released
    produce_block( fc::hours(1) );
    produce_blocks(1);
 
    REQUIRE_MATCHING_OBJECT( voter( "alice1111111", core_sym::from_string("0.0000") ), get_voter_info( "alice1111111" ) );
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(bob111111111), N(processrefunds), mvo()("max", 10) ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("1000.0000"), get_balance( "alice1111111" ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( processrefunds_matured, eosio_system_tester ) try {
+   cross_15_percent_threshold();
+
+   issue_and_transfer( "alice1111111", core_sym::from_string("1000.0000"),  config::system_account_name );
+   issue_and_transfer( "bob111111111", core_sym::from_string("1000.0000"),  config::system_account_name );
+   auto queued = [&]( const account_name& owner ) {
+      return !get_row_by_account( config::system_account_name, config::system_account_name, N(refundqueue), owner ).empty();
+   };
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("max must be positive"),
+                        push_action( N(carol1111111), N(processrefunds), mvo()("max", 0) ) );
+
+   BOOST_REQUIRE_EQUAL( success(), stake( "alice1111111", "alice1111111", core_sym::from_string("200.0000"), core_sym::from_string("100.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), stake( "bob111111111", "bob111111111", core_sym::from_string("200.0000"), core_sym::from_string("100.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), unstake( "alice1111111", "alice1111111", core_sym::from_string("200.0000"), core_sym::from_string("100.0000") ) );
+   produce_block( fc::hours(1) );
+   BOOST_REQUIRE_EQUAL( success(), unstake( "bob111111111", "bob111111111", core_sym::from_string("200.0000"), core_sym::from_string("100.0000") ) );
+   BOOST_REQUIRE( queued( N(alice1111111) ) );
+   BOOST_REQUIRE( queued( N(bob111111111) ) );
+
+   // nothing has matured yet
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(carol1111111), N(processrefunds), mvo()("max", 10) ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("700.0000"), get_balance( "alice1111111" ) );
+   BOOST_REQUIRE( queued( N(alice1111111) ) );
+
+   // only alice's refund has matured
+   produce_block( fc::hours(3*24-1) );
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(carol1111111), N(processrefunds), mvo()("max", 10) ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("1000.0000"), get_balance( "alice1111111" ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("700.0000"), get_balance( "bob111111111" ) );
+   BOOST_TEST_REQUIRE( get_refund_request( N(alice1111111) ).is_null() );
+   BOOST_REQUIRE( !queued( N(alice1111111) ) );
+   BOOST_REQUIRE( queued( N(bob111111111) ) );
+
+   // bob's refund is not paid out on its own once matured
+   produce_block( fc::hours(1) );
    produce_blocks(1);
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("700.0000"), get_balance( "bob111111111" ) );
+   BOOST_REQUIRE( queued( N(bob111111111) ) );
+
+   // queueing again is a no-op for queued owners and owners without a refund
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("no owners"),
+                        push_action( N(carol1111111), N(queuerefunds), mvo()("owners", vector<account_name>{}) ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("too many owners"),
+                        push_action( N(carol1111111), N(queuerefunds), mvo()("owners", vector<account_name>( 101, N(bob111111111) )) ) );
+   BOOST_REQUIRE_EQUAL( success(),
+                        push_action( N(carol1111111), N(queuerefunds), mvo()("owners", vector<account_name>{ N(alice1111111), N(bob111111111) }) ) );
+   BOOST_REQUIRE( !queued( N(alice1111111) ) );
+
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(carol1111111), N(processrefunds), mvo()("max", 10) ) );
    BOOST_REQUIRE_EQUAL( core_sym::from_string("1000.0000"), get_balance( "alice1111111" ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("1000.0000"), get_balance( "bob111111111" ) );
+   BOOST_REQUIRE( !queued( N(bob111111111) ) );
 } FC_LOG_AND_RETHROW()
 
 BOOST_FIXTURE_TEST_CASE( stake_unstake_with_transfer, eosio_system_tester ) try {
@@ -560,10 +691,11 @@ BOOST_FIXTURE_TEST_CASE( stake_unstake_with_transfer, eosio_system_tester ) try
    produce_block( fc::hours(3*24-1) );
    produce_blocks(1);
    BOOST_REQUIRE_EQUAL( core_sym::from_string("700.0000"), get_balance( "alice1111111" ) );
-   //after 3 days funds should be released
+   //after 3 days funds can be released
 
    produce_block( fc::hours(1) );
    produce_blocks(1);
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(bob111111111), N(processrefunds), mvo()("max", 10) ) );
 
    BOOST_REQUIRE_EQUAL( core_sym::from_string("1300.0000"), get_balance( "alice1111111" ) );
 
@@ -624,10 +756,11 @@ BOOST_FIXTURE_TEST_CASE( stake_while_pending_refund, eosio_system_tester ) try {
    produce_block( fc::hours(3*24-1) );
    produce_blocks(1);
    BOOST_REQUIRE_EQUAL( core_sym::from_string("700.0000"), get_balance( "alice1111111" ) );
-   //after 3 days funds should be released
+   //after 3 days funds can be released
 
    produce_block( fc::hours(1) );
    produce_blocks(1);
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(bob111111111), N(processrefunds), mvo()("max", 10) ) );
 
    BOOST_REQUIRE_EQUAL( core_sym::from_string("1300.0000"), get_balance( "alice1111111" ) );
 
@@ -816,6 +949,52 @@ BOOST_FIXTURE_TEST_CASE( delegate_to_another_user, eosio_system_tester ) try {
 } FC_LOG_AND_RETHROW()
 
 
+BOOST_FIXTURE_TEST_CASE( delegatebatch_orders, eosio_system_tester ) try {
+   cross_15_percent_threshold();
+
+   issue_and_transfer( "alice1111111", core_sym::from_string("1000.0000"),  config::system_account_name );
+   auto order = []( const char* receiver, const char* net, const char* cpu ) {
+      return mvo()("receiver", receiver)("stake_net_quantity", core_sym::from_string(net))("stake_cpu_quantity", core_sym::from_string(cpu));
+   };
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("no orders"), delegatebatch( N(alice1111111), {} ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("too many orders"),
+                        delegatebatch( N(alice1111111), vector<mvo>( 101, order("bob111111111", "1.0000", "1.0000") ) ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("must stake a positive amount"),
+                        delegatebatch( N(alice1111111), { order("bob111111111", "0.0000", "0.0000") } ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("receiver account does not exist"),
+                        delegatebatch( N(alice1111111), { order("nonexistent", "1.0000", "1.0000") } ) );
+
+   // pending refund of alice covers only what she stakes to herself
+   BOOST_REQUIRE_EQUAL( success(), stake( "alice1111111", "alice1111111", core_sym::from_string("200.0000"), core_sym::from_string("100.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), unstake( "alice1111111", "alice1111111", core_sym::from_string("100.0000"), core_sym::from_string("50.0000") ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("700.0000"), get_balance( "alice1111111" ) );
+
+   // orders for the same receiver are merged
+   BOOST_REQUIRE_EQUAL( success(), delegatebatch( N(alice1111111), { order("bob111111111", "20.0000", "10.0000"),
+                                                                     order("alice1111111", "50.0000", "25.0000"),
+                                                                     order("carol1111111", "5.0000", "5.0000"),
+                                                                     order("bob111111111", "20.0000", "10.0000") } ) );
+   auto total = get_total_stake( "bob111111111" );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("50.0000"), total["net_weight"].as<asset>());
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("30.0000"), total["cpu_weight"].as<asset>());
+   total = get_total_stake( "carol1111111" );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("15.0000"), total["net_weight"].as<asset>());
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("15.0000"), total["cpu_weight"].as<asset>());
+   total = get_total_stake( "alice1111111" );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("160.0000"), total["net_weight"].as<asset>());
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("85.0000"), total["cpu_weight"].as<asset>());
+
+   auto refund = get_refund_request( N(alice1111111) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("50.0000"), refund["net_amount"].as<asset>() );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("25.0000"), refund["cpu_amount"].as<asset>() );
+   // only the stake delegated to bob and carol comes from the liquid balance
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("630.0000"), get_balance( "alice1111111" ) );
+   REQUIRE_MATCHING_OBJECT( voter( "alice1111111", core_sym::from_string("295.0000") ), get_voter_info( "alice1111111" ) );
+   BOOST_REQUIRE_EQUAL( true, get_voter_info( "bob111111111" ).is_null() );
+} FC_LOG_AND_RETHROW()
+
+
 BOOST_FIXTURE_TEST_CASE( stake_unstake_separate, eosio_system_tester ) try {
    cross_15_percent_threshold();
 
@@ -1089,6 +1268,96 @@ BOOST_FIXTURE_TEST_CASE( producer_register_unregister, eosio_system_tester ) try
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( votebatch_merged, eosio_system_tester ) try {
+   create_accounts_with_resources( { N(defproducer1), N(defproducer2), N(defproducer3) } );
+   for( auto p : { N(defproducer1), N(defproducer2), N(defproducer3) } ) {
+      BOOST_REQUIRE_EQUAL( success(), regproducer( p ) );
+   }
+   issue_and_transfer( "bob111111111", core_sym::from_string("2000.0000"),  config::system_account_name );
+   issue_and_transfer( "carol1111111", core_sym::from_string("3000.0000"),  config::system_account_name );
+   BOOST_REQUIRE_EQUAL( success(), stake( "bob111111111", core_sym::from_string("100.0000"), core_sym::from_string("50.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), stake( "carol1111111", core_sym::from_string("200.0000"), core_sym::from_string("100.0000") ) );
+   auto bob_votes   = stake2votes( core_sym::from_string("150.0000") );
+   auto carol_votes = stake2votes( core_sym::from_string("300.0000") );
+
+   auto vote_order = []( const char* voter, vector<account_name> producers ) {
+      return mvo()("voter", voter)("proxy", name(0).to_string())("producers", producers);
+   };
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("no votes"), votebatch( {} ) );
+   {
+      // every voter signs, so the 21 votes need 21 distinct accounts
+      vector<account_name> voters;
+      vector<mvo>          votes;
+      for( char c = 'a'; c <= 'u'; ++c ) {
+         voters.emplace_back( std::string("batchvoter") + c );
+      }
+      create_accounts_with_resources( voters );
+      for( const auto& v : voters ) {
+         votes.push_back( vote_order( v.to_string().c_str(), { N(defproducer1) } ) );
+      }
+      BOOST_REQUIRE_EQUAL( wasm_assert_msg("too many votes"), votebatch( votes ) );
+   }
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("producer votes must be unique and sorted"),
+                        votebatch( { vote_order( "bob111111111", { N(defproducer2), N(defproducer1) } ) } ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("producer defproducer4 is not registered"),
+                        votebatch( { vote_order( "bob111111111", { N(defproducer1) } ),
+                                     vote_order( "carol1111111", { N(defproducer4) } ) } ) );
+
+   BOOST_REQUIRE_EQUAL( success(), votebatch( { vote_order( "bob111111111", { N(defproducer1), N(defproducer2) } ),
+                                                vote_order( "carol1111111", { N(defproducer2), N(defproducer3) } ) } ) );
+   BOOST_TEST_REQUIRE( bob_votes == get_producer_votes( N(defproducer1) )["total_votes"].as_double() );
+   BOOST_TEST_REQUIRE( bob_votes + carol_votes == get_producer_votes( N(defproducer2) )["total_votes"].as_double() );
+   BOOST_TEST_REQUIRE( carol_votes == get_producer_votes( N(defproducer3) )["total_votes"].as_double() );
+   REQUIRE_MATCHING_OBJECT( voter( "bob111111111", core_sym::from_string("150.0000") )
+                            ( "producers", vector<account_name>{ N(defproducer1), N(defproducer2) } ),
+                            get_voter_info( "bob111111111" ) );
+
+   // re-voting moves bob's weight off defproducer1 and carol's off defproducer2
+   BOOST_REQUIRE_EQUAL( success(), votebatch( { vote_order( "bob111111111", { N(defproducer2), N(defproducer3) } ),
+                                                vote_order( "carol1111111", { N(defproducer3) } ) } ) );
+   BOOST_TEST_REQUIRE( 0 == get_producer_votes( N(defproducer1) )["total_votes"].as_double() );
+   BOOST_TEST_REQUIRE( bob_votes == get_producer_votes( N(defproducer2) )["total_votes"].as_double() );
+   BOOST_TEST_REQUIRE( bob_votes + carol_votes == get_producer_votes( N(defproducer3) )["total_votes"].as_double() );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( producer_votes_row, eosio_system_tester ) try {
+   BOOST_REQUIRE_EQUAL( success(), regproducer( N(alice1111111) ) );
+
+   auto votes = get_producer_votes( N(alice1111111) );
+   BOOST_REQUIRE_EQUAL( "alice1111111", votes["owner"].as_string() );
+   BOOST_REQUIRE_EQUAL( 0, votes["total_votes"].as_double() );
+   BOOST_REQUIRE_EQUAL( true, votes["is_active"].as_bool() );
+
+   issue_and_transfer( "bob111111111", core_sym::from_string("2000.0000"),  config::system_account_name );
+   BOOST_REQUIRE_EQUAL( success(), stake( "bob111111111", core_sym::from_string("13.0000"), core_sym::from_string("0.5791") ) );
+   BOOST_REQUIRE_EQUAL( success(), vote( N(bob111111111), { N(alice1111111) } ) );
+
+   // votes are tallied in the hot row only, the metadata row keeps its legacy value
+   votes = get_producer_votes( N(alice1111111) );
+   BOOST_TEST_REQUIRE( stake2votes(core_sym::from_string("13.5791")) == votes["total_votes"].as_double() );
+   vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, N(producers), N(alice1111111) );
+   auto info = abi_ser.binary_to_variant( "producer_info", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+   BOOST_REQUIRE_EQUAL( 0, info["total_votes"].as_double() );
+
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(alice1111111), N(unregprod), mvo()("producer", "alice1111111") ) );
+   votes = get_producer_votes( N(alice1111111) );
+   BOOST_REQUIRE_EQUAL( false, votes["is_active"].as_bool() );
+   BOOST_TEST_REQUIRE( stake2votes(core_sym::from_string("13.5791")) == votes["total_votes"].as_double() );
+
+   // re-registering keeps the tally
+   BOOST_REQUIRE_EQUAL( success(), regproducer( N(alice1111111) ) );
+   votes = get_producer_votes( N(alice1111111) );
+   BOOST_REQUIRE_EQUAL( true, votes["is_active"].as_bool() );
+   BOOST_TEST_REQUIRE( stake2votes(core_sym::from_string("13.5791")) == votes["total_votes"].as_double() );
+
+   // producers of a chain initialized with the `prodvotes` table never need a migration
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("max must be positive"),
+                        push_action( N(bob111111111), N(migrateprods), mvo()("max", 0) ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("producer votes are already migrated"),
+                        push_action( N(bob111111111), N(migrateprods), mvo()("max", 10) ) );
+} FC_LOG_AND_RETHROW()
+
 
 BOOST_FIXTURE_TEST_CASE( producer_wtmsig, eosio_system_tester ) try {
    cross_15_percent_threshold();
@@ -1358,9 +1627,10 @@ BOOST_FIXTURE_TEST_CASE( vote_for_producer, eosio_system_tester, * boost::unit_t
    prod = get_producer_info( "alice1111111" );
    BOOST_TEST_REQUIRE( 0.0 == prod["total_votes"].as_double() );
 
-   //carol1111111 should receive funds in 3 days
+   //carol1111111 can receive funds in 3 days
    produce_block( fc::days(3) );
    produce_block();
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(carol1111111), N(processrefunds), mvo()("max", 10) ) );
    BOOST_REQUIRE_EQUAL( core_sym::from_string("3000.0000"), get_balance( "carol1111111" ) );
 
 } FC_LOG_AND_RETHROW()
@@ -1560,6 +1830,36 @@ BOOST_FIXTURE_TEST_CASE( vote_for_two_producers, eosio_system_tester, * boost::u
 } FC_LOG_AND_RETHROW()
 
 
+BOOST_FIXTURE_TEST_CASE( voter_compact_row, eosio_system_tester ) try {
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(alice1111111), N(regproxy), mvo()("proxy", "alice1111111")("isproxy", true) ) );
+
+   // proxy flag lives in the top bit of flags1, proxied weight in its own row
+   vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, N(voters2), N(alice1111111) );
+   auto row = abi_ser.binary_to_variant( "voter_info2", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+   BOOST_REQUIRE_EQUAL( 0, row["version"].as<uint8_t>() );
+   BOOST_REQUIRE_EQUAL( 0x80000000u, row["flags1"].as<uint32_t>() );
+   data = get_row_by_account( config::system_account_name, config::system_account_name, N(proxies), N(alice1111111) );
+   BOOST_REQUIRE( !data.empty() );
+
+   issue_and_transfer( "bob111111111", core_sym::from_string("1000.0000"),  config::system_account_name );
+   BOOST_REQUIRE_EQUAL( success(), stake( "bob111111111", core_sym::from_string("100.0002"), core_sym::from_string("50.0001") ) );
+   BOOST_REQUIRE_EQUAL( success(), vote( N(bob111111111), vector<account_name>(), "alice1111111" ) );
+   auto proxy_row = abi_ser.binary_to_variant( "proxy_info",
+                                               get_row_by_account( config::system_account_name, config::system_account_name, N(proxies), N(alice1111111) ),
+                                               abi_serializer::create_yield_function(abi_serializer_max_time) );
+   BOOST_TEST_REQUIRE( stake2votes(core_sym::from_string("150.0003")) == proxy_row["proxied_vote_weight"].as_double() );
+
+   // a plain voter gets no proxies row
+   BOOST_REQUIRE( get_row_by_account( config::system_account_name, config::system_account_name, N(proxies), N(bob111111111) ).empty() );
+
+   // unregistering clears the flag but keeps the accumulated weight
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(alice1111111), N(regproxy), mvo()("proxy", "alice1111111")("isproxy", false) ) );
+   auto info = get_voter_info( "alice1111111" );
+   BOOST_REQUIRE_EQUAL( false, info["is_proxy"].as_bool() );
+   BOOST_TEST_REQUIRE( stake2votes(core_sym::from_string("150.0003")) == info["proxied_vote_weight"].as_double() );
+} FC_LOG_AND_RETHROW()
+
+
 BOOST_FIXTURE_TEST_CASE( proxy_register_unregister_keeps_stake, eosio_system_tester ) try {
    //register proxy by first action for this user ever
    BOOST_REQUIRE_EQUAL( success(), push_action(N(alice1111111), N(regproxy), mvo()
@@ -2863,10 +3163,17 @@ BOOST_FIXTURE_TEST_CASE( multiple_namebids, eosio_system_tester ) try {
       BOOST_REQUIRE_EQUAL( success(),
                            bidname( "alice", "prefb", core_sym::from_string("1.1001") ) );
       alice_balance -= core_sym::from_string("1.1001");
-      bob_balance += core_sym::from_string("1.0000");
       BOOST_REQUIRE_EQUAL( bob_balance, get_balance("bob") );
       BOOST_REQUIRE_EQUAL( alice_balance, get_balance("alice") );
+      BOOST_REQUIRE_EQUAL( initial_names_balance + core_sym::from_string("1.1001"), get_balance(N(amax.names)) );
+      BOOST_REQUIRE_EQUAL( core_sym::from_string("1.0000"), get_bid_balance(N(bob))["balance"].as<asset>() );
+      // bob withdraws the bid he was outbid with
+      BOOST_REQUIRE_EQUAL( success(), bidwithdraw( N(bob) ) );
+      bob_balance += core_sym::from_string("1.0000");
+      BOOST_REQUIRE_EQUAL( bob_balance, get_balance("bob") );
       BOOST_REQUIRE_EQUAL( initial_names_balance + core_sym::from_string("0.1001"), get_balance(N(amax.names)) );
+      BOOST_REQUIRE( get_bid_balance(N(bob)).is_null() );
+      BOOST_REQUIRE_EQUAL( wasm_assert_msg("bid balance not found"), bidwithdraw( N(bob) ) );
    }
 
    // david outbids carl on prefd
@@ -2877,7 +3184,6 @@ BOOST_FIXTURE_TEST_CASE( multiple_namebids, eosio_system_tester ) try {
       BOOST_REQUIRE_EQUAL( success(),
                            bidname( "david", "prefd", core_sym::from_string("1.9900") ) );
       david_balance -= core_sym::from_string("1.9900");
-      carl_balance += core_sym::from_string("1.0000");
       BOOST_REQUIRE_EQUAL( carl_balance, get_balance("carl") );
       BOOST_REQUIRE_EQUAL( david_balance, get_balance("david") );
    }
@@ -2888,6 +3194,14 @@ BOOST_FIXTURE_TEST_CASE( multiple_namebids, eosio_system_tester ) try {
                            bidname( "eve", "prefe", core_sym::from_string("1.7200") ) );
    }
 
+   // carl withdraws both outbid bids at once
+   {
+      BOOST_REQUIRE_EQUAL( core_sym::from_string("2.0000"), get_bid_balance(N(carl))["balance"].as<asset>() );
+      BOOST_REQUIRE_EQUAL( success(), bidwithdraw( N(carl) ) );
+      carl_balance += core_sym::from_string("2.0000");
+      BOOST_REQUIRE_EQUAL( carl_balance, get_balance("carl") );
+   }
+
    produce_block( fc::days(14) );
    produce_block();
 
@@ -2977,6 +3291,33 @@ BOOST_FIXTURE_TEST_CASE( namebid_pending_winner, eosio_system_tester ) try {
    create_account_with_resources( N(prefb), N(bob111111111) );
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( namebid_close_many_per_day, eosio_system_tester ) try {
+   cross_15_percent_threshold();
+   produce_block( fc::hours(14*24) );    //wait 14 day for name auction activation
+   transfer( config::system_account_name, N(alice1111111), core_sym::from_string("100000000.0000") );
+
+   BOOST_REQUIRE_EQUAL( error("missing authority of amax"),
+                        push_action( N(alice1111111), N(cfgnamebid), mvo()("max_closes_per_day", 3) ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("max_closes_per_day must be positive"),
+                        push_action( config::system_account_name, N(cfgnamebid), mvo()("max_closes_per_day", 0) ) );
+   BOOST_REQUIRE_EQUAL( success(),
+                        push_action( config::system_account_name, N(cfgnamebid), mvo()("max_closes_per_day", 2) ) );
+
+   BOOST_REQUIRE_EQUAL( success(), bidname( "alice1111111", "prefa", core_sym::from_string( "50.0000" ) ));
+   BOOST_REQUIRE_EQUAL( success(), bidname( "alice1111111", "prefb", core_sym::from_string( "40.0000" ) ));
+   BOOST_REQUIRE_EQUAL( success(), bidname( "alice1111111", "prefc", core_sym::from_string( "30.0000" ) ));
+   produce_block( fc::hours(25) );
+   produce_blocks(2);
+
+   // the two highest auctions close in the same pass, the third waits for the next day
+   BOOST_REQUIRE( get_name_bid( N(prefa) )["high_bid"].as_int64() < 0 );
+   BOOST_REQUIRE( get_name_bid( N(prefb) )["high_bid"].as_int64() < 0 );
+   BOOST_REQUIRE( get_name_bid( N(prefc) )["high_bid"].as_int64() > 0 );
+   produce_block( fc::hours(25) );
+   produce_blocks(2);
+   BOOST_REQUIRE( get_name_bid( N(prefc) )["high_bid"].as_int64() < 0 );
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE( vote_producers_in_and_out, eosio_system_tester ) try {
 
    const asset net = core_sym::from_string("80.0000");
@@ -3728,7 +4069,7 @@ BOOST_FIXTURE_TEST_CASE( buy_sell_sell_rex, eosio_system_tester ) try {
    BOOST_REQUIRE_EQUAL( sellrex( alice, rex_tok ),                           wasm_assert_msg("insufficient funds for current and scheduled orders") );
    BOOST_REQUIRE_EQUAL( ratio * payment.get_amount() - rex_tok.get_amount(), get_rex_order( alice )["rex_requested"].as<asset>().get_amount() );
    BOOST_REQUIRE_EQUAL( success(),                                           consolidate( alice ) );
-   BOOST_REQUIRE_EQUAL( 0,                                                   get_rex_balance_obj( alice )["rex_maturities"].get_array().size() );
+   BOOST_REQUIRE_EQUAL( 0,                                                   rex_maturity_count( get_rex_balance_obj( alice ) ) );
 
    produce_block( fc::days(26) );
    produce_blocks(2);
@@ -4032,6 +4373,37 @@ BOOST_FIXTURE_TEST_CASE( rex_loans, eosio_system_tester ) try {
 } FC_LOG_AND_RETHROW()
 
 
+BOOST_FIXTURE_TEST_CASE( rexrun_budgets, eosio_system_tester ) try {
+
+   const asset init_balance = core_sym::from_string("1000000.0000");
+   const std::vector<account_name> accounts = { N(aliceaccount), N(bobbyaccount) };
+   account_name alice = accounts[0], bob = accounts[1];
+   setup_rex_accounts( accounts, init_balance );
+
+   BOOST_REQUIRE_EQUAL( success(), buyrex( alice, core_sym::from_string("50000.0000") ) );
+   for (uint8_t i = 0; i < 3; ++i) {
+      BOOST_REQUIRE_EQUAL( success(), rentcpu( bob, bob, core_sym::from_string("100.0000") ) );
+   }
+   produce_block( fc::days(31) );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("max_steps must be positive"), rexrun( alice, 1, 1, 1, 0 ) );
+
+   // per-queue budget
+   BOOST_REQUIRE_EQUAL( success(), rexrun( alice, 1, 0, 0, 10 ) );
+   BOOST_REQUIRE_EQUAL( true,      get_cpu_loan(1).is_null() );
+   BOOST_REQUIRE_EQUAL( false,     get_cpu_loan(2).is_null() );
+
+   // total budget
+   BOOST_REQUIRE_EQUAL( success(), rexrun( alice, 5, 5, 5, 1 ) );
+   BOOST_REQUIRE_EQUAL( true,      get_cpu_loan(2).is_null() );
+   BOOST_REQUIRE_EQUAL( false,     get_cpu_loan(3).is_null() );
+
+   BOOST_REQUIRE_EQUAL( success(), rexrun( alice, 5, 5, 5, 15 ) );
+   BOOST_REQUIRE_EQUAL( true,      get_cpu_loan(3).is_null() );
+
+} FC_LOG_AND_RETHROW()
+
+
 BOOST_FIXTURE_TEST_CASE( rex_loan_checks, eosio_system_tester ) try {
 
    const int64_t ratio        = 10000;
@@ -4109,6 +4481,8 @@ BOOST_FIXTURE_TEST_CASE( ramfee_namebid_to_rex, eosio_system_tester ) try {
    BOOST_REQUIRE_EQUAL( success(),                        bidname( carol, N(rndmbid), core_sym::from_string("23.7000") ) );
    BOOST_REQUIRE_EQUAL( core_sym::from_string("23.7000"), get_balance( N(amax.names) ) );
    BOOST_REQUIRE_EQUAL( success(),                        bidname( alice, N(rndmbid), core_sym::from_string("29.3500") ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("53.0500"), get_balance( N(amax.names) ));
+   BOOST_REQUIRE_EQUAL( success(),                        bidwithdraw( carol ) );
    BOOST_REQUIRE_EQUAL( core_sym::from_string("29.3500"), get_balance( N(amax.names) ));
 
    produce_block( fc::hours(24) );
@@ -4152,7 +4526,7 @@ BOOST_FIXTURE_TEST_CASE( rex_maturity, eosio_system_tester ) try {
       auto rex_balance = get_rex_balance_obj( alice );
       BOOST_REQUIRE_EQUAL( 550000 * rex_ratio, rex_balance["rex_balance"].as<asset>().get_amount() );
       BOOST_REQUIRE_EQUAL( 0,                  rex_balance["matured_rex"].as<int64_t>() );
-      BOOST_REQUIRE_EQUAL( 2,                  rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 2,                  rex_maturity_count( rex_balance ) );
 
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("insufficient available rex"),
                            sellrex( alice, asset::from_string("115000.0000 REX") ) );
@@ -4161,7 +4535,7 @@ BOOST_FIXTURE_TEST_CASE( rex_maturity, eosio_system_tester ) try {
       rex_balance = get_rex_balance_obj( alice );
       BOOST_REQUIRE_EQUAL( 250000 * rex_ratio, rex_balance["rex_balance"].as<asset>().get_amount() );
       BOOST_REQUIRE_EQUAL( 0,                  rex_balance["matured_rex"].as<int64_t>() );
-      BOOST_REQUIRE_EQUAL( 1,                  rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 1,                  rex_maturity_count( rex_balance ) );
       produce_block( fc::hours(23) );
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("insufficient available rex"),
                            sellrex( alice, asset::from_string("250000.0000 REX") ) );
@@ -4170,14 +4544,14 @@ BOOST_FIXTURE_TEST_CASE( rex_maturity, eosio_system_tester ) try {
       rex_balance = get_rex_balance_obj( alice );
       BOOST_REQUIRE_EQUAL( 1200000000,         rex_balance["rex_balance"].as<asset>().get_amount() );
       BOOST_REQUIRE_EQUAL( 1200000000,         rex_balance["matured_rex"].as<int64_t>() );
-      BOOST_REQUIRE_EQUAL( 0,                  rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 0,                  rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("insufficient available rex"),
                            sellrex( alice, asset::from_string("130000.0000 REX") ) );
       BOOST_REQUIRE_EQUAL( success(),          sellrex( alice, asset::from_string("120000.0000 REX") ) );
       rex_balance = get_rex_balance_obj( alice );
       BOOST_REQUIRE_EQUAL( 0,                  rex_balance["rex_balance"].as<asset>().get_amount() );
       BOOST_REQUIRE_EQUAL( 0,                  rex_balance["matured_rex"].as<int64_t>() );
-      BOOST_REQUIRE_EQUAL( 0,                  rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 0,                  rex_maturity_count( rex_balance ) );
    }
 
    {
@@ -4194,23 +4568,23 @@ BOOST_FIXTURE_TEST_CASE( rex_maturity, eosio_system_tester ) try {
 
       auto rex_balance = get_rex_balance_obj( bob );
       BOOST_REQUIRE_EQUAL( 8 * rex_bucket.get_amount(), rex_balance["rex_balance"].as<asset>().get_amount() );
-      BOOST_REQUIRE_EQUAL( 5,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 5,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 3 * rex_bucket.get_amount(), rex_balance["matured_rex"].as<int64_t>() );
 
       BOOST_REQUIRE_EQUAL( success(),                   updaterex( bob ) );
       rex_balance = get_rex_balance_obj( bob );
-      BOOST_REQUIRE_EQUAL( 4,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 4,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 4 * rex_bucket.get_amount(), rex_balance["matured_rex"].as<int64_t>() );
 
       produce_block( fc::hours(2) );
       BOOST_REQUIRE_EQUAL( success(),                   updaterex( bob ) );
       rex_balance = get_rex_balance_obj( bob );
-      BOOST_REQUIRE_EQUAL( 4,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 4,                           rex_maturity_count( rex_balance ) );
 
       produce_block( fc::hours(1) );
       BOOST_REQUIRE_EQUAL( success(),                   sellrex( bob, asset( 3 * rex_bucket.get_amount(), rex_sym ) ) );
       rex_balance = get_rex_balance_obj( bob );
-      BOOST_REQUIRE_EQUAL( 4,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 4,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( rex_bucket.get_amount(),     rex_balance["matured_rex"].as<int64_t>() );
 
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("insufficient available rex"),
@@ -4218,18 +4592,18 @@ BOOST_FIXTURE_TEST_CASE( rex_maturity, eosio_system_tester ) try {
       BOOST_REQUIRE_EQUAL( success(),                   sellrex( bob, asset( rex_bucket.get_amount(), rex_sym ) ) );
       rex_balance = get_rex_balance_obj( bob );
       BOOST_REQUIRE_EQUAL( 4 * rex_bucket.get_amount(), rex_balance["rex_balance"].as<asset>().get_amount() );
-      BOOST_REQUIRE_EQUAL( 4,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 4,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 0,                           rex_balance["matured_rex"].as<int64_t>() );
 
       produce_block( fc::hours(23) );
       BOOST_REQUIRE_EQUAL( success(),                   updaterex( bob ) );
       rex_balance = get_rex_balance_obj( bob );
-      BOOST_REQUIRE_EQUAL( 3,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 3,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( rex_bucket.get_amount(),     rex_balance["matured_rex"].as<int64_t>() );
 
       BOOST_REQUIRE_EQUAL( success(),                   consolidate( bob ) );
       rex_balance = get_rex_balance_obj( bob );
-      BOOST_REQUIRE_EQUAL( 1,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 1,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 0,                           rex_balance["matured_rex"].as<int64_t>() );
 
       produce_block( fc::days(3) );
@@ -4239,7 +4613,7 @@ BOOST_FIXTURE_TEST_CASE( rex_maturity, eosio_system_tester ) try {
       BOOST_REQUIRE_EQUAL( success(),                   sellrex( bob, asset( 4 * rex_bucket.get_amount(), rex_sym ) ) );
       rex_balance = get_rex_balance_obj( bob );
       BOOST_REQUIRE_EQUAL( 0,                           rex_balance["rex_balance"].as<asset>().get_amount() );
-      BOOST_REQUIRE_EQUAL( 0,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 0,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 0,                           rex_balance["matured_rex"].as<int64_t>() );
    }
 
@@ -4301,19 +4675,19 @@ BOOST_FIXTURE_TEST_CASE( rex_savings, eosio_system_tester ) try {
 
       auto rex_balance = get_rex_balance_obj( alice );
       BOOST_REQUIRE_EQUAL( 8 * rex_bucket.get_amount(), rex_balance["rex_balance"].as<asset>().get_amount() );
-      BOOST_REQUIRE_EQUAL( 5,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 5,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 4 * rex_bucket.get_amount(), rex_balance["matured_rex"].as<int64_t>() );
 
       BOOST_REQUIRE_EQUAL( success(),                   mvtosavings( alice, asset( 8 * rex_bucket.get_amount(), rex_sym ) ) );
       rex_balance = get_rex_balance_obj( alice );
-      BOOST_REQUIRE_EQUAL( 1,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 1,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 0,                           rex_balance["matured_rex"].as<int64_t>() );
       produce_block( fc::days(1000) );
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("insufficient available rex"),
                            sellrex( alice, asset::from_string( "1.0000 REX" ) ) );
       BOOST_REQUIRE_EQUAL( success(),                   mvfrsavings( alice, asset::from_string( "10.0000 REX" ) ) );
       rex_balance = get_rex_balance_obj( alice );
-      BOOST_REQUIRE_EQUAL( 2,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 2,                           rex_maturity_count( rex_balance ) );
       produce_block( fc::days(3) );
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("insufficient available rex"),
                            sellrex( alice, asset::from_string( "1.0000 REX" ) ) );
@@ -4323,7 +4697,7 @@ BOOST_FIXTURE_TEST_CASE( rex_savings, eosio_system_tester ) try {
                            sellrex( alice, asset::from_string( "10.0001 REX" ) ) );
       BOOST_REQUIRE_EQUAL( success(),                   sellrex( alice, asset::from_string( "10.0000 REX" ) ) );
       rex_balance = get_rex_balance_obj( alice );
-      BOOST_REQUIRE_EQUAL( 1,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 1,                           rex_maturity_count( rex_balance ) );
       produce_block( fc::days(100) );
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("insufficient available rex"),
                            sellrex( alice, asset::from_string( "0.0001 REX" ) ) );
@@ -4342,32 +4716,32 @@ BOOST_FIXTURE_TEST_CASE( rex_savings, eosio_system_tester ) try {
 
       auto rex_balance = get_rex_balance_obj( bob );
       BOOST_REQUIRE_EQUAL( 5 * rex_bucket.get_amount(), rex_balance["rex_balance"].as<asset>().get_amount() );
-      BOOST_REQUIRE_EQUAL( 5,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 5,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 0,                           rex_balance["matured_rex"].as<int64_t>() );
       BOOST_REQUIRE_EQUAL( success(),                   mvtosavings( bob, asset( rex_bucket.get_amount() / 2, rex_sym ) ) );
       rex_balance = get_rex_balance_obj( bob );
-      BOOST_REQUIRE_EQUAL( 6,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 6,                           rex_maturity_count( rex_balance ) );
 
       BOOST_REQUIRE_EQUAL( success(),                   mvtosavings( bob, asset( rex_bucket.get_amount() / 2, rex_sym ) ) );
       rex_balance = get_rex_balance_obj( bob );
-      BOOST_REQUIRE_EQUAL( 5,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 5,                           rex_maturity_count( rex_balance ) );
       produce_block( fc::days(1) );
       BOOST_REQUIRE_EQUAL( success(),                   sellrex( bob, rex_bucket ) );
       rex_balance = get_rex_balance_obj( bob );
-      BOOST_REQUIRE_EQUAL( 4,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 4,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 0,                           rex_balance["matured_rex"].as<int64_t>() );
       BOOST_REQUIRE_EQUAL( 4 * rex_bucket.get_amount(), rex_balance["rex_balance"].as<asset>().get_amount() );
 
       BOOST_REQUIRE_EQUAL( success(),                   mvtosavings( bob, asset( 3 * rex_bucket.get_amount() / 2, rex_sym ) ) );
       rex_balance = get_rex_balance_obj( bob );
-      BOOST_REQUIRE_EQUAL( 3,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 3,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("insufficient available rex"),
                            sellrex( bob, rex_bucket ) );
 
       produce_block( fc::days(1) );
       BOOST_REQUIRE_EQUAL( success(),                   sellrex( bob, rex_bucket ) );
       rex_balance = get_rex_balance_obj( bob );
-      BOOST_REQUIRE_EQUAL( 2,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 2,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 0,                           rex_balance["matured_rex"].as<int64_t>() );
       BOOST_REQUIRE_EQUAL( 3 * rex_bucket.get_amount(), rex_balance["rex_balance"].as<asset>().get_amount() );
 
@@ -4376,7 +4750,7 @@ BOOST_FIXTURE_TEST_CASE( rex_savings, eosio_system_tester ) try {
                            sellrex( bob, rex_bucket ) );
       BOOST_REQUIRE_EQUAL( success(),                   sellrex( bob, asset( rex_bucket.get_amount() / 2, rex_sym ) ) );
       rex_balance = get_rex_balance_obj( bob );
-      BOOST_REQUIRE_EQUAL( 1,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 1,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 0,                           rex_balance["matured_rex"].as<int64_t>() );
       BOOST_REQUIRE_EQUAL( 5 * rex_bucket.get_amount(), 2 * rex_balance["rex_balance"].as<asset>().get_amount() );
 
@@ -4386,12 +4760,12 @@ BOOST_FIXTURE_TEST_CASE( rex_savings, eosio_system_tester ) try {
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("insufficient REX in savings"),
                            mvfrsavings( bob, asset( 3 * rex_bucket.get_amount(), rex_sym ) ) );
       BOOST_REQUIRE_EQUAL( success(),                   mvfrsavings( bob, rex_bucket ) );
-      BOOST_REQUIRE_EQUAL( 2,                           get_rex_balance_obj( bob )["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 2,                           rex_maturity_count( get_rex_balance_obj( bob ) ) );
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("insufficient REX balance"),
                            mvtosavings( bob, asset( 3 * rex_bucket.get_amount() / 2, rex_sym ) ) );
       produce_block( fc::days(1) );
       BOOST_REQUIRE_EQUAL( success(),                   mvfrsavings( bob, rex_bucket ) );
-      BOOST_REQUIRE_EQUAL( 3,                           get_rex_balance_obj( bob )["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 3,                           rex_maturity_count( get_rex_balance_obj( bob ) ) );
       produce_block( fc::days(4) );
       BOOST_REQUIRE_EQUAL( success(),                   sellrex( bob, rex_bucket ) );
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("insufficient available rex"),
@@ -4399,22 +4773,22 @@ BOOST_FIXTURE_TEST_CASE( rex_savings, eosio_system_tester ) try {
       produce_block( fc::days(1) );
       BOOST_REQUIRE_EQUAL( success(),                   sellrex( bob, rex_bucket ) );
       rex_balance = get_rex_balance_obj( bob );
-      BOOST_REQUIRE_EQUAL( 1,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 1,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( rex_bucket.get_amount() / 2, rex_balance["rex_balance"].as<asset>().get_amount() );
 
       BOOST_REQUIRE_EQUAL( success(),                   mvfrsavings( bob, asset( rex_bucket.get_amount() / 4, rex_sym ) ) );
       produce_block( fc::days(2) );
       BOOST_REQUIRE_EQUAL( success(),                   mvfrsavings( bob, asset( rex_bucket.get_amount() / 8, rex_sym ) ) );
-      BOOST_REQUIRE_EQUAL( 3,                           get_rex_balance_obj( bob )["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 3,                           rex_maturity_count( get_rex_balance_obj( bob ) ) );
       BOOST_REQUIRE_EQUAL( success(),                   consolidate( bob ) );
-      BOOST_REQUIRE_EQUAL( 2,                           get_rex_balance_obj( bob )["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 2,                           rex_maturity_count( get_rex_balance_obj( bob ) ) );
 
       produce_block( fc::days(5) );
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("insufficient available rex"),
                            sellrex( bob, asset( rex_bucket.get_amount() / 2, rex_sym ) ) );
       BOOST_REQUIRE_EQUAL( success(),                   sellrex( bob, asset( 3 * rex_bucket.get_amount() / 8, rex_sym ) ) );
       rex_balance = get_rex_balance_obj( bob );
-      BOOST_REQUIRE_EQUAL( 1,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 1,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 0,                           rex_balance["matured_rex"].as<int64_t>() );
       BOOST_REQUIRE_EQUAL( rex_bucket.get_amount() / 8, rex_balance["rex_balance"].as<asset>().get_amount() );
       BOOST_REQUIRE_EQUAL( success(),                   mvfrsavings( bob, get_rex_balance( bob ) ) );
@@ -4459,21 +4833,21 @@ BOOST_FIXTURE_TEST_CASE( rex_savings, eosio_system_tester ) try {
       BOOST_REQUIRE_EQUAL( rex_bucket,                  get_rex_balance( carol ) );
       auto rex_balance = get_rex_balance_obj( carol );
 
-      BOOST_REQUIRE_EQUAL( 1,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 1,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 0,                           rex_balance["matured_rex"].as<int64_t>() );
       produce_block( fc::days(1) );
       BOOST_REQUIRE_EQUAL( success(),                   buyrex( carol, payment ) );
       rex_balance = get_rex_balance_obj( carol );
-      BOOST_REQUIRE_EQUAL( 2,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 2,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 0,                           rex_balance["matured_rex"].as<int64_t>() );
 
       BOOST_REQUIRE_EQUAL( success(),                   mvtosavings( carol, half_rex_bucket ) );
       rex_balance = get_rex_balance_obj( carol );
-      BOOST_REQUIRE_EQUAL( 3,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 3,                           rex_maturity_count( rex_balance ) );
 
       BOOST_REQUIRE_EQUAL( success(),                   buyrex( carol, half_payment ) );
       rex_balance = get_rex_balance_obj( carol );
-      BOOST_REQUIRE_EQUAL( 3,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 3,                           rex_maturity_count( rex_balance ) );
 
       produce_block( fc::days(5) );
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("asset must be a positive amount of (REX, 4)"),
@@ -4484,7 +4858,7 @@ BOOST_FIXTURE_TEST_CASE( rex_savings, eosio_system_tester ) try {
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("insufficient REX in savings"),
                            mvfrsavings( carol, asset::from_string("0.0001 REX") ) );
       rex_balance = get_rex_balance_obj( carol );
-      BOOST_REQUIRE_EQUAL( 1,                           rex_balance["rex_maturities"].get_array().size() );
+      BOOST_REQUIRE_EQUAL( 1,                           rex_maturity_count( rex_balance ) );
       BOOST_REQUIRE_EQUAL( 5 * half_rex_bucket_amount,  rex_balance["rex_balance"].as<asset>().get_amount() );
       BOOST_REQUIRE_EQUAL( 2 * rex_bucket_amount,       rex_balance["matured_rex"].as<int64_t>() );
       produce_block( fc::days(5) );
@@ -63,6 +63,34 @@ public:
       return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "account", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
    }
 
+   fc::variant get_blacklist_state()
+   {
+      vector<char> data = get_row_by_account( N(amax.token), N(amax.token), N(blackstate), N(blackstate) );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "blacklist_state", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+   }
+
+   fc::variant get_transfer_totals( const string& symbolname )
+   {
+      auto symbol_code = eosio::chain::symbol::from_string(symbolname).to_symbol_code().value;
+      vector<char> data = get_row_by_account( N(amax.token), name(symbol_code), N(transtotal), N(transtotal) );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "transfer_totals", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+   }
+
+   // sums the transfer count and volume of all statistics shards
+   std::pair<uint64_t, uint64_t> get_transfer_shards( const string& symbolname )
+   {
+      auto symbol_code = eosio::chain::symbol::from_string(symbolname).to_symbol_code().value;
+      std::pair<uint64_t, uint64_t> sum;
+      for( uint64_t shard = 0; shard < 16; ++shard ) {
+         vector<char> data = get_row_by_account( N(amax.token), name(symbol_code), N(transtats), name(shard) );
+         if( data.empty() ) continue;
+         auto row = abi_ser.binary_to_variant( "transfer_stats", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
+         sum.first  += row["transfers"].as<uint64_t>();
+         sum.second += row["volume"].as<uint64_t>();
+      }
+      return sum;
+   }
+
    action_result create( account_name issuer,
                          asset        maximum_supply ) {
 
@@ -100,6 +128,26 @@ public:
       );
    }
 
+   action_result transfermany( account_name from, const vector<mvo>& transfers ) {
+      return push_action( from, N(transfermany), mvo()
+           ( "from", from)
+           ( "transfers", transfers)
+      );
+   }
+
+   action_result blacklist( const vector<account_name>& targets, bool to_add ) {
+      return push_action( N(amax.token), N(blacklist), mvo()
+           ( "targets", targets)
+           ( "to_add", to_add)
+      );
+   }
+
+   action_result rollup( account_name actor, const string& sym ) {
+      return push_action( actor, N(rollup), mvo()
+           ( "sym", sym)
+      );
+   }
+
    action_result open( account_name owner,
                        const string& symbolname,
                        account_name ram_payer    ) {
@@ -346,6 +394,133 @@ BOOST_FIXTURE_TEST_CASE( transfer_tests, eosio_token_tester ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( transfermany_tests, eosio_token_tester ) try {
+
+   create( N(alice), asset::from_string("1000 CERO"));
+   create( N(alice), asset::from_string("1000.000 TKN"));
+   produce_blocks(1);
+   issue( N(alice), asset::from_string("1000 CERO"), "hola" );
+   issue( N(alice), asset::from_string("1000.000 TKN"), "hola" );
+
+   auto order = []( account_name to, const string& quantity ) {
+      return mvo()("to", to)("quantity", quantity)("memo", "payout");
+   };
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "no transfers" ), transfermany( N(alice), {} ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "too many transfers" ),
+      transfermany( N(alice), vector<mvo>( 51, order( N(bob), "1 CERO" ) ) )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "cannot transfer to self" ),
+      transfermany( N(alice), { order( N(bob), "1 CERO" ), order( N(alice), "1 CERO" ) } )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "to account does not exist" ),
+      transfermany( N(alice), { order( N(dave), "1 CERO" ) } )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "symbol precision mismatch" ),
+      transfermany( N(alice), { order( N(bob), "1.0 CERO" ) } )
+   );
+   // the debit is checked against the sum of all orders of a symbol
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "overdrawn balance" ),
+      transfermany( N(alice), { order( N(bob), "600 CERO" ), order( N(carol), "401 CERO" ) } )
+   );
+
+   vector<mvo> orders = { order( N(bob), "300 CERO" ), order( N(carol), "200 CERO" ),
+                          order( N(bob), "100 CERO" ), order( N(carol), "1.500 TKN" ) };
+   auto trace = base_tester::push_action( N(amax.token), N(transfermany), N(alice),
+                                          mvo()("from", "alice")("transfers", orders) );
+
+   // every order is sent as an inline `transfer` notice, delivered to amax.token, `from` and `to`
+   std::map<account_name, size_t> notices;
+   vector<fc::variant> notice_data;
+   for( const auto& at : trace->action_traces ) {
+      if( at.act.account != N(amax.token) || at.act.name != N(transfer) ) continue;
+      ++notices[at.receiver];
+      if( at.receiver == N(amax.token) ) {
+         notice_data.push_back( abi_ser.binary_to_variant( "transfer", at.act.data, abi_serializer::create_yield_function(abi_serializer_max_time) ) );
+      }
+   }
+   BOOST_REQUIRE_EQUAL( 4u, notices[N(amax.token)] );
+   BOOST_REQUIRE_EQUAL( 4u, notices[N(alice)] );
+   BOOST_REQUIRE_EQUAL( 2u, notices[N(bob)] );
+   BOOST_REQUIRE_EQUAL( 2u, notices[N(carol)] );
+   BOOST_REQUIRE_EQUAL( orders.size(), notice_data.size() );
+   for( size_t i = 0; i < orders.size(); ++i ) {
+      REQUIRE_MATCHING_OBJECT( notice_data[i], mvo()("from", "alice")("to", orders[i]["to"])
+                                                    ("quantity", orders[i]["quantity"])("memo", "payout") );
+   }
+
+   // the notices neither move balances nor count in the statistics a second time
+   REQUIRE_MATCHING_OBJECT( get_account(N(alice), "0,CERO"), mvo()("balance", "400 CERO") );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "0,CERO"), mvo()("balance", "400 CERO") );
+   REQUIRE_MATCHING_OBJECT( get_account(N(carol), "0,CERO"), mvo()("balance", "200 CERO") );
+   REQUIRE_MATCHING_OBJECT( get_account(N(alice), "3,TKN"), mvo()("balance", "998.500 TKN") );
+   REQUIRE_MATCHING_OBJECT( get_account(N(carol), "3,TKN"), mvo()("balance", "1.500 TKN") );
+   BOOST_REQUIRE( get_transfer_shards( "0,CERO" ) == std::make_pair( uint64_t(3), uint64_t(600) ) );
+   BOOST_REQUIRE( get_transfer_shards( "3,TKN" ) == std::make_pair( uint64_t(1), uint64_t(1500) ) );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( blacklist_state_tests, eosio_token_tester ) try {
+
+   create( N(alice), asset::from_string("1000 CERO"));
+   produce_blocks(1);
+   issue( N(alice), asset::from_string("1000 CERO"), "hola" );
+   BOOST_REQUIRE( get_blacklist_state().is_null() );
+
+   BOOST_REQUIRE_EQUAL( success(), blacklist( { N(bob) }, true ) );
+   auto state = get_blacklist_state();
+   BOOST_REQUIRE_EQUAL( 1u, state["count"].as<uint32_t>() );
+   BOOST_REQUIRE_EQUAL( 16u, state["bloom"].get_array().size() );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "to acccount blacklisted!" ),
+      transfer( N(alice), N(bob), asset::from_string("1 CERO"), "hola" )
+   );
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(alice), N(carol), asset::from_string("1 CERO"), "hola" ) );
+
+   // adding an account twice does not count it twice
+   BOOST_REQUIRE_EQUAL( success(), blacklist( { N(bob), N(carol) }, true ) );
+   BOOST_REQUIRE_EQUAL( 2u, get_blacklist_state()["count"].as<uint32_t>() );
+
+   BOOST_REQUIRE_EQUAL( success(), blacklist( { N(bob), N(carol) }, false ) );
+   BOOST_REQUIRE_EQUAL( 0u, get_blacklist_state()["count"].as<uint32_t>() );
+   // removals rebuild the summary, which clears the bits of the removed accounts
+   for( const auto& word : get_blacklist_state()["bloom"].get_array() ) {
+      BOOST_REQUIRE_EQUAL( 0u, word.as<uint64_t>() );
+   }
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(alice), N(bob), asset::from_string("1 CERO"), "hola" ) );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( transfer_stats_tests, eosio_token_tester ) try {
+
+   create( N(alice), asset::from_string("1000 CERO"));
+   produce_blocks(1);
+   issue( N(alice), asset::from_string("1000 CERO"), "hola" );
+
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(alice), N(bob), asset::from_string("300 CERO"), "hola" ) );
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(bob), N(carol), asset::from_string("100 CERO"), "hola" ) );
+   BOOST_REQUIRE_EQUAL( success(),
+      transfermany( N(alice), { mvo()("to", "bob")("quantity", "10 CERO")("memo", ""),
+                                mvo()("to", "carol")("quantity", "20 CERO")("memo", "") } )
+   );
+   BOOST_REQUIRE( (std::pair<uint64_t, uint64_t>{ 4, 430 }) == get_transfer_shards( "0,CERO" ) );
+   BOOST_REQUIRE( get_transfer_totals( "0,CERO" ).is_null() );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "token with symbol does not exist" ), rollup( N(carol), "TKN" ) );
+   BOOST_REQUIRE_EQUAL( success(), rollup( N(carol), "CERO" ) );
+   auto totals = get_transfer_totals( "0,CERO" );
+   BOOST_REQUIRE_EQUAL( 4u, totals["transfers"].as<uint64_t>() );
+   BOOST_REQUIRE_EQUAL( 430u, totals["volume"].as<uint64_t>() );
+   BOOST_REQUIRE( (std::pair<uint64_t, uint64_t>{ 0, 0 }) == get_transfer_shards( "0,CERO" ) );
+
+   produce_blocks(1);
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(carol), N(alice), asset::from_string("5 CERO"), "hola" ) );
+   BOOST_REQUIRE_EQUAL( success(), rollup( N(bob), "CERO" ) );
+   totals = get_transfer_totals( "0,CERO" );
+   BOOST_REQUIRE_EQUAL( 5u, totals["transfers"].as<uint64_t>() );
+   BOOST_REQUIRE_EQUAL( 435u, totals["volume"].as<uint64_t>() );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE( open_tests, eosio_token_tester ) try {
 
    auto token = create( N(alice), asset::from_string("1000 CERO"));
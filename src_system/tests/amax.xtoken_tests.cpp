@@ -51,6 +51,15 @@ public:
       return base_tester::push_action( std::move(act), signer.to_uint64_t() );
    }
 
+   // pushes an action of amax.xtoken and returns the asset it returns
+   asset push_action_for_asset( const account_name& signer, const action_name &name, const variant_object &data ) {
+      auto trace = base_tester::push_action( N(amax.xtoken), name, signer, data );
+      BOOST_REQUIRE( trace && trace->receipt );
+      const auto& root = trace->action_traces.front();
+      BOOST_REQUIRE_EQUAL( N(amax.xtoken), root.receiver );
+      return fc::raw::unpack<asset>( root.return_value );
+   }
+
    action_result push_deposit_action(const account_name& signer, const action_name &name, const variant_object &data ) {
       auto deposit_abi_ser = get_deposit_abi_serializer();
       string action_type_name = deposit_abi_ser.get_action_type(name);
@@ -79,6 +88,19 @@ public:
       return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "account", data, abi_serializer::create_yield_function(abi_serializer_max_time) );
    }
 
+   // sums the fee rows of the token, fees accrued since the last claimfees()
+   asset get_accrued_fees( const symbol& symb )
+   {
+      auto symbol_code = symb.to_symbol_code().value;
+      asset fees( 0, symb );
+      for ( uint64_t shard = 0; shard < 16; ++shard ) {
+         vector<char> data = get_row_by_account( N(amax.xtoken), name(symbol_code), N(feeshards), name(shard) );
+         if ( data.empty() ) continue;
+         fees += abi_ser.binary_to_variant( "fee_shard", data, abi_serializer::create_yield_function(abi_serializer_max_time) )["fees"].as<asset>();
+      }
+      return fees;
+   }
+
    abi_serializer get_deposit_abi_serializer() const {
       abi_serializer deposit_abi_ser;
       const auto& accnt = control->db().get<account_object,by_name>( N(deposit) );
@@ -177,6 +199,19 @@ public:
       );
    }
 
+   action_result feeaccrual( account_name issuer, const symbol &symbol, bool is_fee_accrued ) {
+      return push_action( issuer, N(feeaccrual), mvo()
+           ( "symbol", symbol )
+           ( "is_fee_accrued", is_fee_accrued )
+      );
+   }
+
+   action_result claimfees( account_name actor, const symbol &symbol ) {
+      return push_action( actor, N(claimfees), mvo()
+           ( "symbol", symbol )
+      );
+   }
+
    action_result feeexempt( account_name issuer, const symbol &symbol, const name &account, bool is_fee_exempt ) {
       return push_action( issuer, N(feeexempt), mvo()
            ( "symbol", symbol )
@@ -200,6 +235,22 @@ public:
       );
    }
 
+   action_result freezeaccts( account_name issuer, const symbol &symbol, const vector<name> &owners, bool is_frozen ) {
+      return push_action( issuer, N(freezeaccts), mvo()
+           ( "symbol", symbol )
+           ( "owners", owners )
+           ( "is_frozen", is_frozen )
+      );
+   }
+
+   action_result feeexempts( account_name issuer, const symbol &symbol, const vector<name> &owners, bool is_fee_exempt ) {
+      return push_action( issuer, N(feeexempts), mvo()
+           ( "symbol", symbol )
+           ( "owners", owners )
+           ( "is_fee_exempt", is_fee_exempt )
+      );
+   }
+
    abi_serializer abi_ser;
 };
 
@@ -517,6 +568,7 @@ BOOST_FIXTURE_TEST_CASE( transfer_fee_tests, amax_xtoken_tester ) try {
       ("fee_receiver", "fee.receiver")
       ("fee_ratio", 30 )
       ("min_fee_quantity", "0.0000 CERO")
+      ("is_fee_accrued", false)
    );
 
    auto alice_balance = get_account(N(alice), "4,CERO");
@@ -581,6 +633,82 @@ BOOST_FIXTURE_TEST_CASE( transfer_fee_tests, amax_xtoken_tester ) try {
 } FC_LOG_AND_RETHROW()
 
 
+BOOST_FIXTURE_TEST_CASE( fee_accrual_tests, amax_xtoken_tester ) try {
+
+   auto token = create( N(alice), asset::from_string("1000.0000 CERO"));
+   produce_blocks(1);
+
+   feeratio( N(alice), SYMB(4,CERO), 30); // 0.3%, boost 10000
+   feereceiver( N(alice), SYMB(4,CERO), N(fee.receiver));
+   issue( N(alice), asset::from_string("1000.0000 CERO"), "hola" );
+
+   BOOST_REQUIRE_EQUAL( error( "missing authority of alice" ), feeaccrual( N(bob), SYMB(4,CERO), true ) );
+   BOOST_REQUIRE_EQUAL( success(), feeaccrual( N(alice), SYMB(4,CERO), true ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "no accrued fees" ), claimfees( N(carol), SYMB(4,CERO) ) );
+
+   // fees accrue on the fee rows, fee.receiver is not credited yet; transfer reports the fee it charged
+   auto transfer_fee = [&]( account_name from, account_name to, const string& quantity ) {
+      return push_action_for_asset( from, N(transfer),
+                                    mvo()("from", from)("to", to)("quantity", quantity)("memo", "") );
+   };
+   BOOST_REQUIRE_EQUAL( asset::from_string("0.9000 CERO"), transfer_fee( N(alice), N(bob), "300.0000 CERO" ) );
+   BOOST_REQUIRE_EQUAL( asset::from_string("0.3000 CERO"), transfer_fee( N(alice), N(carol), "100.0000 CERO" ) );
+   REQUIRE_MATCHING_OBJECT_INVERSE( get_account(N(bob), "4,CERO"), mvo()("balance", "299.1000 CERO") );
+   REQUIRE_MATCHING_OBJECT_INVERSE( get_account(N(carol), "4,CERO"), mvo()("balance", "99.7000 CERO") );
+   REQUIRE_MATCHING_OBJECT_INVERSE( get_account(N(fee.receiver), "4,CERO"), mvo()("balance", "0.0000 CERO") );
+   REQUIRE_MATCHING_OBJECT_INVERSE( get_stats("4,CERO"), mvo()("is_fee_accrued", true) );
+   BOOST_REQUIRE_EQUAL( asset::from_string("1.2000 CERO"), get_accrued_fees( SYMB(4,CERO) ) );
+
+   BOOST_REQUIRE_EQUAL( asset::from_string("1.2000 CERO"),
+                        push_action_for_asset( N(carol), N(claimfees), mvo()("symbol", SYMB(4,CERO)) ) );
+   REQUIRE_MATCHING_OBJECT_INVERSE( get_account(N(fee.receiver), "4,CERO"), mvo()("balance", "1.2000 CERO") );
+   BOOST_REQUIRE_EQUAL( asset::from_string("0.0000 CERO"), get_accrued_fees( SYMB(4,CERO) ) );
+
+   // back to direct crediting
+   BOOST_REQUIRE_EQUAL( success(), feeaccrual( N(alice), SYMB(4,CERO), false ) );
+   BOOST_REQUIRE_EQUAL( asset::from_string("0.3000 CERO"), transfer_fee( N(alice), N(bob), "100.0000 CERO" ) );
+   REQUIRE_MATCHING_OBJECT_INVERSE( get_account(N(fee.receiver), "4,CERO"), mvo()("balance", "1.5000 CERO") );
+   BOOST_REQUIRE_EQUAL( asset::from_string("0.0000 CERO"), get_accrued_fees( SYMB(4,CERO) ) );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( batch_account_flags_tests, amax_xtoken_tester ) try {
+
+   auto token = create( N(alice), asset::from_string("1000.0000 CERO"));
+   produce_blocks(1);
+   issue( N(alice), asset::from_string("1000.0000 CERO"), "hola" );
+   BOOST_REQUIRE_EQUAL( success(), open( N(bob), "4,CERO", N(alice) ) );
+   BOOST_REQUIRE_EQUAL( success(), open( N(carol), "4,CERO", N(alice) ) );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "no accounts" ), freezeaccts( N(alice), SYMB(4,CERO), {}, true ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "too many accounts, max 100" ),
+      feeexempts( N(alice), SYMB(4,CERO), vector<name>( 101, N(bob) ), true )
+   );
+   BOOST_REQUIRE_EQUAL( error( "missing authority of alice" ), freezeaccts( N(bob), SYMB(4,CERO), { N(bob) }, true ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "account of token does not exist" ),
+      freezeaccts( N(alice), SYMB(4,CERO), { N(bob), N(deposit) }, true )
+   );
+
+   BOOST_REQUIRE_EQUAL( success(), freezeaccts( N(alice), SYMB(4,CERO), { N(bob), N(carol) }, true ) );
+   BOOST_REQUIRE_EQUAL( success(), feeexempts( N(alice), SYMB(4,CERO), { N(bob), N(carol) }, true ) );
+   for( auto acct : { N(bob), N(carol) } ) {
+      REQUIRE_MATCHING_OBJECT( get_account( acct, "4,CERO" ), mvo()
+         ("balance", "0.0000 CERO")
+         ("is_frozen", true)
+         ("is_fee_exempt", true)
+      );
+   }
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "to account is frozen" ),
+      transfer( N(alice), N(bob), asset::from_string("1.0000 CERO"), "" )
+   );
+
+   BOOST_REQUIRE_EQUAL( success(), freezeaccts( N(alice), SYMB(4,CERO), { N(carol) }, false ) );
+   REQUIRE_MATCHING_OBJECT_INVERSE( get_account( N(bob), "4,CERO" ), mvo()("is_frozen", true) );
+   REQUIRE_MATCHING_OBJECT_INVERSE( get_account( N(carol), "4,CERO" ), mvo()("is_frozen", false) );
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(alice), N(carol), asset::from_string("1.0000 CERO"), "" ) );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE( deposit, amax_xtoken_tester ) try {
 
    auto rlm = control->get_resource_limits_manager();
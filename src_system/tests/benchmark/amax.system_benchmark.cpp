@@ -0,0 +1,223 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/chain/resource_limits.hpp>
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+
+#include "../amax.system_tester.hpp"
+
+/**
+ * Replays canonical system contract workloads and records what every action is billed.
+ *
+ * Each row of the CSV written to `$AMAX_BENCHMARK_CSV` (default `system_benchmark.csv`) holds the totals of one
+ * workload step: `workload,action,count,elapsed_us,cpu_usage_us,net_usage,ram_delta`. Workloads use fixed
+ * accounts and amounts, so `net_usage` and `ram_delta` are stable across runs and may not grow over the baseline
+ * CSV; `cpu_usage_us` varies with the host and may exceed it by `$AMAX_BENCHMARK_CPU_TOLERANCE` percent (default
+ * 20). The baseline must hold a row for every step in `required_steps`. It is `system_benchmark_baseline.csv` next
+ * to this file, or `$AMAX_BENCHMARK_BASELINE` if set (set it empty to skip the check). Refresh the committed
+ * baseline on the reference host after an intended change with `AMAX_BENCHMARK_BASELINE=` and
+ * `AMAX_BENCHMARK_CSV=<source dir>/tests/benchmark/system_benchmark_baseline.csv`.
+ *
+ * REX and powerup actions are not activated in this contract and have no workload here.
+ */
+
+using namespace eosio_system;
+
+namespace {
+
+struct bench_row {
+   std::string workload;
+   std::string action;
+   uint64_t    count        = 0;
+   int64_t     elapsed_us   = 0;
+   int64_t     cpu_usage_us = 0;
+   int64_t     net_usage    = 0;
+   int64_t     ram_delta    = 0;
+
+   void add( const transaction_trace_ptr& trace ) {
+      ++count;
+      elapsed_us += trace->elapsed.count();
+      net_usage  += trace->net_usage;
+      if( trace->receipt ) {
+         cpu_usage_us += trace->receipt->cpu_usage_us;
+      }
+      for( const auto& at : trace->action_traces ) {
+         for( const auto& d : at.account_ram_deltas ) {
+            ram_delta += d.delta;
+         }
+      }
+   }
+};
+
+class benchmark_tester : public eosio_system_tester {
+public:
+   ~benchmark_tester() {
+      write_csv();
+   }
+
+   bench_row& row( const std::string& workload, const std::string& action ) {
+      auto key = workload + "," + action;
+      auto itr = rows.find( key );
+      if( itr == rows.end() ) {
+         itr = rows.emplace( key, bench_row{ workload, action } ).first;
+         order.push_back( key );
+      }
+      return itr->second;
+   }
+
+   void measure( const std::string& workload, const account_name& actor, const action_name& act, const variant_object& data ) {
+      auto trace = base_tester::push_action( config::system_account_name, act, actor, data );
+      BOOST_REQUIRE( trace && trace->receipt );
+      row( workload, act.to_string() ).add( trace );
+   }
+
+   void write_csv() {
+      const char* path = std::getenv( "AMAX_BENCHMARK_CSV" );
+      std::ofstream out( path ? path : "system_benchmark.csv" );
+      out << "workload,action,count,elapsed_us,cpu_usage_us,net_usage,ram_delta\n";
+      for( const auto& key : order ) {
+         const auto& r = rows.at( key );
+         out << r.workload << ',' << r.action << ',' << r.count << ',' << r.elapsed_us << ','
+             << r.cpu_usage_us << ',' << r.net_usage << ',' << r.ram_delta << '\n';
+      }
+   }
+
+   // Steps of the canonical workloads, which the baseline has to cover.
+   static constexpr const char* required_steps[] = {
+      "vote30,voteproducer", "proxy,voteproducer", "proxy,delegatebw",
+      "ram,buyram", "ram,buyrambytes", "ram,sellram", "onblock,onblock",
+   };
+
+   // Steps missing from the baseline, other than `required_steps`, are new and always pass.
+   void check_baseline() {
+      const char* path = std::getenv( "AMAX_BENCHMARK_BASELINE" );
+      if( !path ) path = AMAX_BENCHMARK_BASELINE_DEFAULT;
+      if( !*path ) return;
+      std::ifstream in( path );
+      BOOST_REQUIRE_MESSAGE( in.good(), "cannot read benchmark baseline " << path );
+      const char* tolerance_env = std::getenv( "AMAX_BENCHMARK_CPU_TOLERANCE" );
+      const int64_t cpu_tolerance_pct = tolerance_env ? std::stoll( tolerance_env ) : 20;
+
+      std::set<std::string> checked;
+
+      std::string line;
+      std::getline( in, line ); // header
+      while( std::getline( in, line ) ) {
+         std::vector<std::string> cols;
+         std::stringstream ss( line );
+         for( std::string col; std::getline( ss, col, ',' ); ) {
+            cols.push_back( col );
+         }
+         if( cols.size() != 7 ) continue;
+         auto itr = rows.find( cols[0] + "," + cols[1] );
+         if( itr == rows.end() ) continue;
+         checked.insert( itr->first );
+         BOOST_CHECK_MESSAGE( itr->second.cpu_usage_us * 100 <= std::stoll( cols[4] ) * ( 100 + cpu_tolerance_pct ),
+                              line << ": cpu_usage_us grew to " << itr->second.cpu_usage_us );
+         BOOST_CHECK_MESSAGE( itr->second.net_usage <= std::stoll( cols[5] ),
+                              line << ": net_usage grew to " << itr->second.net_usage );
+         BOOST_CHECK_MESSAGE( itr->second.ram_delta <= std::stoll( cols[6] ),
+                              line << ": ram_delta grew to " << itr->second.ram_delta );
+      }
+      for( const auto* step : required_steps ) {
+         BOOST_CHECK_MESSAGE( checked.count( step ), "benchmark baseline " << path << " has no row for " << step );
+      }
+   }
+
+   std::vector<account_name> make_producers( const std::string& root, uint32_t n ) {
+      std::vector<account_name> producers;
+      for( uint32_t i = 0; i < n; ++i ) {
+         std::string suffix;
+         for( uint32_t v = i; suffix.size() < 2; v /= 26 ) {
+            suffix.insert( suffix.begin(), char('a' + v % 26) );
+         }
+         producers.emplace_back( root + suffix );
+      }
+      setup_producer_accounts( producers );
+      for( const auto& p : producers ) {
+         regproducer( p );
+      }
+      produce_block();
+      return producers;
+   }
+
+   std::map<std::string, bench_row> rows;
+   std::vector<std::string>         order;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(eosio_system_benchmark)
+
+BOOST_FIXTURE_TEST_CASE( system_benchmark, benchmark_tester ) try {
+   cross_15_percent_threshold();
+
+   // voteproducer with 30 producers
+   auto producers = make_producers( "benchprod", 30 );
+   std::sort( producers.begin(), producers.end() );
+   issue_and_transfer( "alice1111111", core_sym::from_string("100000.0000"), config::system_account_name );
+   BOOST_REQUIRE_EQUAL( success(), stake( "alice1111111", core_sym::from_string("10000.0000"), core_sym::from_string("10000.0000") ) );
+   measure( "vote30", N(alice1111111), N(voteproducer),
+            mvo()("voter", "alice1111111")("proxy", name(0).to_string())("producers", producers) );
+   measure( "vote30", N(alice1111111), N(delegatebw),
+            mvo()("from", "alice1111111")("receiver", "alice1111111")
+                 ("stake_net_quantity", core_sym::from_string("1.0000"))("stake_cpu_quantity", core_sym::from_string("1.0000"))
+                 ("transfer", false) );
+
+   // proxy fan-out: 100 voters proxy to one account voting for 30 producers
+   create_accounts_with_resources( { N(benchproxy) } );
+   issue_and_transfer( "benchproxy", core_sym::from_string("1000.0000"), config::system_account_name );
+   BOOST_REQUIRE_EQUAL( success(), stake( N(benchproxy), core_sym::from_string("100.0000"), core_sym::from_string("100.0000") ) );
+   measure( "proxy", N(benchproxy), N(regproxy), mvo()("proxy", "benchproxy")("isproxy", true) );
+   measure( "proxy", N(benchproxy), N(voteproducer),
+            mvo()("voter", "benchproxy")("proxy", name(0).to_string())("producers", producers) );
+   std::vector<account_name> voters;
+   for( char c = 'a'; c < 'a' + 10; ++c ) {
+      for( char d = 'a'; d < 'a' + 10; ++d ) {
+         voters.emplace_back( std::string("benchvoter") + c + d );
+      }
+   }
+   create_accounts_with_resources( voters );
+   for( const auto& v : voters ) {
+      issue_and_transfer( v, core_sym::from_string("100.0000"), config::system_account_name );
+      BOOST_REQUIRE_EQUAL( success(), stake( v, core_sym::from_string("10.0000"), core_sym::from_string("10.0000") ) );
+      measure( "proxy", v, N(voteproducer), mvo()("voter", v)("proxy", "benchproxy")("producers", vector<account_name>()) );
+   }
+   // a stake change of a proxied voter propagates through the proxy to all 30 producers
+   measure( "proxy", voters.front(), N(delegatebw),
+            mvo()("from", voters.front())("receiver", voters.front())
+                 ("stake_net_quantity", core_sym::from_string("1.0000"))("stake_cpu_quantity", core_sym::from_string("1.0000"))
+                 ("transfer", false) );
+   produce_block();
+
+   // buyram / sellram
+   for( int i = 0; i < 100; ++i ) {
+      measure( "ram", N(alice1111111), N(buyram),
+               mvo()("payer", "alice1111111")("receiver", "alice1111111")("quant", core_sym::from_string("10.0000")) );
+      measure( "ram", N(alice1111111), N(buyrambytes),
+               mvo()("payer", "alice1111111")("receiver", "alice1111111")("bytes", 1024) );
+      measure( "ram", N(alice1111111), N(sellram), mvo()("account", "alice1111111")("bytes", 1024) );
+      if( i % 10 == 9 ) produce_block();
+   }
+
+   // onblock x10k, with the 30 voted producers and a daily producer schedule update
+   produce_block();
+   auto conn = control->applied_transaction.connect( [&]( const auto& t ) {
+      const auto& trace = std::get<0>( t );
+      if( !trace->action_traces.empty() && trace->action_traces.front().act.name == N(onblock) ) {
+         row( "onblock", "onblock" ).add( trace );
+      }
+   } );
+   produce_blocks( 10000 );
+   conn.disconnect();
+   BOOST_REQUIRE_EQUAL( 10000u, row( "onblock", "onblock" ).count );
+
+   check_baseline();
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <eosio/asset.hpp>
+#include <eosio/eosio.hpp>
+
+#include <array>
+
+namespace amax {
+
+using namespace eosio;
+
+/**
+ * A balance to read: the bank (token contract) and the token symbol.
+ */
+struct balance_slot {
+   name     bank;
+   symbol   symb;
+};
+
+struct bank_account {
+   asset balance;
+   uint64_t primary_key() const {return balance.symbol.code().raw();}
+};
+typedef eosio::multi_index< name("accounts"), bank_account > tbl_bank_accounts;
+
+/**
+ * Reads the balances of `account` for all `slots` in one pass.
+ * Consecutive slots of the same bank share one table handle, so list the slots grouped by bank.
+ * A missing balance row reads as zero.
+ */
+template<size_t N>
+std::array<asset, N> read_balances(const name& account, const std::array<balance_slot, N>& slots) {
+   std::array<asset, N> balances;
+   for (size_t i = 0; i < N; ) {
+      tbl_bank_accounts accts(slots[i].bank, account.value);
+      do {
+         auto itr = accts.find(slots[i].symb.code().raw());
+         balances[i] = (itr != accts.end()) ? itr->balance : asset(0, slots[i].symb);
+         ++i;
+      } while (i < N && slots[i].bank == slots[i - 1].bank);
+   }
+   return balances;
+}
+
+}
@@ -2,6 +2,9 @@
 #include <eosio/eosio.hpp>
 
 #include <string>
+#include <vector>
+
+#include "balance_reader.hpp"
 
 namespace amax {
 
@@ -20,47 +23,63 @@ static constexpr symbol   METH   = symbol(symbol_code("METH"), 8);
 static constexpr symbol   MBTC   = symbol(symbol_code("MBTC"), 8);
 static constexpr symbol   MBNB   = symbol(symbol_code("MBNB"), 6);
 
+// grouped by bank for read_balances()
+static constexpr std::array<balance_slot, 7> CURRENCIES = {{
+   { AMAX_BANK,   AMAX  },
+   { APL_BANK,    APL   },
+   { CNYD_BANK,   CNYD  },
+   { MIRROR_BANK, MUSDT },
+   { MIRROR_BANK, MBNB  },
+   { MIRROR_BANK, MBTC  },
+   { MIRROR_BANK, METH  }
+}};
+
+static constexpr uint32_t MAX_VIEW_ACCOUNTS = 100;
+
+struct currency_balances {
+   name     account;
+   asset    amax;
+   asset    apl;
+   asset    cnyd;
+   asset    musdt;
+   asset    mbnb;
+   asset    mbtc;
+   asset    meth;
+
+   EOSLIB_SERIALIZE( currency_balances, (account)(amax)(apl)(cnyd)(musdt)(mbnb)(mbtc)(meth) )
+};
+
 class [[eosio::contract("currencyview")]] currencyview : public contract {
 public:
    using contract::contract;
 
-   ACTION view( const name& account ) {
-      auto amax_bal     = get_balance(AMAX_BANK,   AMAX,    account);
-      auto apl_bal      = get_balance(APL_BANK,    APL,     account);
-      auto cnyd_bal     = get_balance(CNYD_BANK,   CNYD,    account);
-      auto musdt_bal    = get_balance(MIRROR_BANK, MUSDT,   account);
-      auto mbtc_bal     = get_balance(MIRROR_BANK, MBTC,    account);
-      auto meth_bal     = get_balance(MIRROR_BANK, METH,    account);
-      auto mbnb_bal     = get_balance(MIRROR_BANK, MBNB,    account);
+   /**
+    * Returns the balances of `account` as the action return value.
+    */
+   [[eosio::action]]
+   currency_balances view( const name& account ) {
+      return get_balances(account);
+   }
 
-      auto res          = "Asset currency view >>>    \n[\n  \""
-                           + amax_bal.to_string()  + "\",\n  \"" 
-                           + apl_bal.to_string()   + "\",\n  \"" 
-                           + cnyd_bal.to_string()  + "\",\n  \"" 
-                           + musdt_bal.to_string() + "\",\n  \""
-                           + mbnb_bal.to_string()  + "\",\n  \""
-                           + mbtc_bal.to_string()  + "\",\n  \""
-                           + meth_bal.to_string()  + "\n]";
-                          
+   /**
+    * Returns the balances of every account in `accounts` as the action return value.
+    */
+   [[eosio::action]]
+   std::vector<currency_balances> viewmany( const std::vector<name>& accounts ) {
+      check(accounts.size() <= MAX_VIEW_ACCOUNTS, "too many accounts, max " + std::to_string(MAX_VIEW_ACCOUNTS));
 
-      check(false, res );
+      std::vector<currency_balances> res;
+      res.reserve(accounts.size());
+      for (const auto& account : accounts) {
+         res.push_back(get_balances(account));
+      }
+      return res;
    }
 
-   struct accounts {
-      asset balance;
-      uint64_t primary_key() const {return balance.symbol.code().raw();}
-   };
-   typedef eosio::multi_index< name("accounts"), accounts > tbl_accounts;
-
 private:
-   asset get_balance(const name& bank, const symbol& symb, const name& account) {
-      tbl_accounts tmp(bank, account.value);
-      auto itr = tmp.find(symb.code().raw());
-
-      if (itr != tmp.end())
-         return itr->balance;
-      else 
-         return asset(0, symb);
+   currency_balances get_balances(const name& account) {
+      auto bals = read_balances(account, CURRENCIES);
+      return { account, bals[0], bals[1], bals[2], bals[3], bals[4], bals[5], bals[6] };
    }
 };
 }